@@ -0,0 +1,189 @@
+; Длинная арифметика из add.asm в виде функций по System V AMD64 ABI для статической библиотеки longarith.
+; Длинные числа -- массивы qword, младший первый; длина в qword'ах, может быть нулевой.
+; Аргументы приходят в rdi, rsi, rdx, rcx, результат возвращается в rax;
+; сохраняемые вызываемой стороной регистры сохраняются: mul_long_long кладёт rbx, r12 и r13
+; на стек и восстанавливает перед выходом, остальные функции их не трогают. Прототипы -- в longarith.h
+
+                section         .text
+
+                global          add_long_long
+                global          sub_long_long
+                global          add_long_short
+                global          mul_long_short
+                global          div_long_short
+                global          mul_long_long
+
+; adds two long numbers
+;    rdi -- address of summand #1 (long number)
+;    rsi -- address of summand #2 (long number)
+;    rdx -- length of long numbers in qwords
+; result:
+;    sum is written to rdi
+;    rax -- carry
+add_long_long:
+                xor             eax, eax
+                mov             rcx, rdx
+                jrcxz           .done
+.loop:
+                mov             rax, [rsi]
+                lea             rsi, [rsi + 8]
+                adc             [rdi], rax
+                lea             rdi, [rdi + 8]
+                dec             rcx
+                jnz             .loop
+
+                setc            al
+                movzx           eax, al
+.done:
+                ret
+
+; subtracts long number from long number
+;    rdi -- address of minuend (long number)
+;    rsi -- address of subtrahend (long number)
+;    rdx -- length of long numbers in qwords
+; result:
+;    difference is written to rdi
+;    rax -- borrow
+sub_long_long:
+                xor             eax, eax
+                mov             rcx, rdx
+                jrcxz           .done
+.loop:
+                mov             rax, [rsi]
+                lea             rsi, [rsi + 8]
+                sbb             [rdi], rax
+                lea             rdi, [rdi + 8]
+                dec             rcx
+                jnz             .loop
+
+                setc            al
+                movzx           eax, al
+.done:
+                ret
+
+; adds 64-bit number to long number
+;    rdi -- address of summand #1 (long number)
+;    rsi -- length of long number in qwords
+;    rdx -- summand #2 (64-bit unsigned)
+; result:
+;    sum is written to rdi
+;    rax -- carry
+add_long_short:
+                mov             rax, rdx
+                mov             rcx, rsi
+                jrcxz           .done
+.loop:
+                add             [rdi], rax
+                mov             eax, 0
+                adc             rax, 0
+                jz              .done
+                add             rdi, 8
+                dec             rcx
+                jnz             .loop
+.done:
+                ret
+
+; multiplies long number by a short
+;    rdi -- address of multiplier #1 (long number)
+;    rsi -- length of long number in qwords
+;    rdx -- multiplier #2 (64-bit unsigned)
+; result:
+;    product is written to rdi
+;    rax -- high qword of product
+mul_long_short:
+                mov             r8, rdx
+                mov             rcx, rsi
+                xor             r9, r9
+                jrcxz           .done
+.loop:
+                mov             rax, [rdi]
+                mul             r8
+                add             rax, r9
+                adc             rdx, 0
+                mov             [rdi], rax
+                add             rdi, 8
+                mov             r9, rdx
+                dec             rcx
+                jnz             .loop
+.done:
+                mov             rax, r9
+                ret
+
+; divides long number by a short
+;    rdi -- address of dividend (long number)
+;    rsi -- length of long number in qwords
+;    rdx -- divisor (64-bit unsigned, non-zero)
+; result:
+;    quotient is written to rdi
+;    rax -- remainder
+div_long_short:
+                mov             r8, rdx
+                mov             rcx, rsi
+                xor             edx, edx
+                jrcxz           .done
+                lea             rdi, [rdi + 8 * rcx - 8]
+.loop:
+                mov             rax, [rdi]
+                div             r8
+                mov             [rdi], rax
+                sub             rdi, 8
+                dec             rcx
+                jnz             .loop
+.done:
+                mov             rax, rdx
+                ret
+
+; multiplies two long numbers of equal length
+;    rdi -- address of product (long number of 2 * rcx qwords, must not overlap arguments)
+;    rsi -- address of multiplier #1 (long number)
+;    rdx -- address of multiplier #2 (long number)
+;    rcx -- length of multipliers in qwords
+; result:
+;    product is written to rdi
+mul_long_long:
+                push            rbx
+                push            r12
+                push            r13
+
+                mov             r8, rdx
+                mov             r12, rcx
+                ; обнуляем произведение
+                mov             r10, rdi
+                lea             rcx, [r12 + r12]
+                xor             eax, eax
+                rep stosq
+                mov             rdi, r10
+                test            r12, r12
+                jz              .done
+
+                ; строка за строкой: rdi[i..i + n] += a * b[i]
+                xor             r11, r11
+.row:
+                mov             rbx, [r8 + 8 * r11]
+                xor             r9, r9
+                xor             r13, r13
+.col:
+                mov             rax, [rsi + 8 * r13]
+                mul             rbx
+                add             rax, r9
+                adc             rdx, 0
+                lea             r10, [r11 + r13]
+                add             [rdi + 8 * r10], rax
+                adc             rdx, 0
+                mov             r9, rdx
+                inc             r13
+                cmp             r13, r12
+                jne             .col
+
+                lea             r10, [r11 + r12]
+                mov             [rdi + 8 * r10], r9
+                inc             r11
+                cmp             r11, r12
+                jne             .row
+.done:
+                pop             r13
+                pop             r12
+                pop             rbx
+                ret
+
+                section         .note.GNU-stack noalloc noexec nowrite progbits
@@ -0,0 +1,32 @@
+#ifndef LONGARITH_H
+#define LONGARITH_H
+
+// Прототипы функций из longarith.asm (статическая библиотека longarith, System V AMD64 ABI).
+// Длинные числа -- массивы qword, младший первый; n -- длина в qword'ах, может быть нулевой.
+// Все операции, кроме mul_long_long, работают на месте над первым аргументом.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// dst[0..n) += src[0..n), возвращает перенос
+uint64_t add_long_long(uint64_t *dst, uint64_t const *src, size_t n);
+// dst[0..n) -= src[0..n), возвращает заём
+uint64_t sub_long_long(uint64_t *dst, uint64_t const *src, size_t n);
+// dst[0..n) += x, возвращает перенос
+uint64_t add_long_short(uint64_t *dst, size_t n, uint64_t x);
+// dst[0..n) *= x, возвращает старший qword произведения
+uint64_t mul_long_short(uint64_t *dst, size_t n, uint64_t x);
+// dst[0..n) /= d, возвращает остаток; d != 0
+uint64_t div_long_short(uint64_t *dst, size_t n, uint64_t d);
+// res[0..2n) = a[0..n) * b[0..n); res не пересекается с a и b
+void mul_long_long(uint64_t *res, uint64_t const *a, uint64_t const *b, size_t n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //LONGARITH_H
@@ -0,0 +1,45 @@
+#ifndef ALLOCATOR_RESOURCE_H
+#define ALLOCATOR_RESOURCE_H
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <new>
+
+// Оборачивает обычный аллокатор (разделяемой памяти, NUMA-пула и т.п.) в std::pmr::memory_resource,
+// чтобы его можно было отдать big_integer: big_integer a(0, big_integer::allocator_type(&resource));
+template <typename Alloc>
+struct allocator_resource : std::pmr::memory_resource {
+	explicit allocator_resource(Alloc const &alloc = Alloc())
+		: allocator(alloc) {}
+
+  private:
+	using block_t = std::max_align_t;
+	using block_allocator = typename std::allocator_traits<Alloc>::template rebind_alloc<block_t>;
+	using traits = std::allocator_traits<block_allocator>;
+
+	block_allocator allocator;
+
+	static size_t blocks(size_t bytes) {
+		return (bytes + sizeof(block_t) - 1) / sizeof(block_t);
+	}
+
+	void *do_allocate(size_t bytes, size_t alignment) override {
+		if (alignment > alignof(block_t)) {
+			throw std::bad_alloc();
+		}
+		return &*traits::allocate(allocator, blocks(bytes));
+	}
+
+	void do_deallocate(void *p, size_t bytes, size_t) override {
+		auto ptr = std::pointer_traits<typename traits::pointer>::pointer_to(*static_cast<block_t *>(p));
+		traits::deallocate(allocator, ptr, blocks(bytes));
+	}
+
+	bool do_is_equal(std::pmr::memory_resource const &other) const noexcept override {
+		auto *that = dynamic_cast<allocator_resource const *>(&other);
+		return that != nullptr && that->allocator == allocator;
+	}
+};
+
+#endif //ALLOCATOR_RESOURCE_H
@@ -0,0 +1,73 @@
+#include "barrett_reducer.h"
+#include "limb_kernels.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+barrett_reducer::barrett_reducer(big_integer const &m)
+	: d(m < 0 ? -m : m), n(d.size()) {
+	if (d == 0) {
+		throw std::runtime_error("division by zero");
+	}
+	// лимбы делителя читаются напрямую, поэтому он хранится в каноническом виде
+	d.normalize();
+	mu = (big_integer(1) << static_cast<int>(64 * n)) / d;
+}
+
+big_integer const &barrett_reducer::modulus() const {
+	return d;
+}
+
+// q = floor(floor(x / B^(n-1)) * mu / B^(n+1)) меньше floor(x / d) не больше чем на 2, поэтому x - q * d
+// достаточно считать по модулю B^(n+1). Оба произведения неполные: у q1 * mu не нужны столбцы младше n - 1
+// (это уменьшает q ещё не больше чем на 1), у q * d -- столбцы старше n
+void barrett_reducer::reduce(big_integer &res, big_integer const &x) const {
+	scratch_space::frame frame;
+	size_t un;
+	digit_t const *u = x.magnitude(frame, un);
+	if (un > 2 * n) {
+		big_integer::divide(nullptr, &res, x, d);
+		return;
+	}
+	if (un < n || (un == n && limb_kernels::cmp_n(u, d.value.data(), n) < 0)) {
+		if (&res != &x) {
+			res = x;
+		}
+		return;
+	}
+	size_t k = n + 1;
+	digit_t const *q1 = u + n - 1;
+	size_t q1n = un - (n - 1);
+	size_t mn = mu.size();  // n + 1 или n + 2
+	digit_t *q2 = frame.alloc(q1n + mn);
+	std::fill(q2, q2 + q1n + mn, 0);
+	for (size_t j = 0; j < q1n; ++j) {
+		size_t i = j < n - 1 ? n - 1 - j : 0;
+		q2[j + mn] = limb_kernels::addmul_1(q2 + j + i, mu.value.data() + i, mn - i, q1[j]);
+	}
+	digit_t const *q3 = q2 + k;
+	size_t q3n = q1n + mn - k;
+
+	// r = (x - q * d) mod B^(n+1)
+	digit_t *qd = frame.alloc(k);
+	std::fill(qd, qd + k, 0);
+	for (size_t j = 0; j < std::min(q3n, k); ++j) {
+		size_t len = std::min(n, k - j);
+		digit_t carry = limb_kernels::addmul_1(qd + j, d.value.data(), len, q3[j]);
+		if (j + len < k) {
+			qd[j + len] = carry;
+		}
+	}
+	digit_t *r = frame.alloc(k);
+	std::fill(r, r + k, 0);
+	std::copy(u, u + std::min(un, k), r);
+	limb_kernels::sub_n(r, r, qd, k);
+
+	digit_t *dk = frame.alloc(k);
+	std::copy(d.value.begin(), d.value.end(), dk);
+	dk[n] = 0;
+	while (limb_kernels::cmp_n(r, dk, k) >= 0) {
+		limb_kernels::sub_n(r, r, dk, k);
+	}
+	res.assign_magnitude(r, k, x.inf_1_after_last_digit);
+}
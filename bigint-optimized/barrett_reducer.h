@@ -0,0 +1,29 @@
+#ifndef BARRETT_REDUCER_H
+#define BARRETT_REDUCER_H
+
+#include <cstddef>
+
+#include "big_integer.h"
+
+// Остаток по фиксированному модулю m (любому ненулевому, в том числе чётному) методом Барретта.
+// Обратная величина mu = floor(B^(2n) / d), где d = |m|, B = 2^32 и n -- число лимбов d, считается один раз,
+// после чего x % m для |x| < B^(2n) обходится двумя неполными умножениями и парой вычитаний.
+// Для больших |x| reduce честно делит.
+struct barrett_reducer {
+	explicit barrett_reducer(big_integer const &m);
+
+	// |m|
+	big_integer const &modulus() const;
+
+	// res = x % m со знаком x, как у operator%; res может совпадать с x
+	void reduce(big_integer &res, big_integer const &x) const;
+
+  private:
+	using digit_t = big_integer::digit_t;
+
+	big_integer d;  // |m|
+	big_integer mu;
+	size_t n;
+};
+
+#endif //BARRETT_REDUCER_H
@@ -1,4 +1,9 @@
 #include "big_integer.h"
+#include "barrett_reducer.h"
+#include "limb_arena.h"
+#include "limb_kernels.h"
+#include "montgomery_context.h"
+#include "scratch_space.h"
 
 #include <cstddef>
 #include <cstdint>
@@ -6,61 +11,111 @@
 #include <vector>
 #include <iostream>
 #include <algorithm>
+#include <cassert>
+#include <cmath>
 
 #define to32(a) static_cast<uint32_t>(a)
 #define to_digit(a) to32(a)
 #define to64(a) static_cast<uint64_t>(a)
 #define to128(a) static_cast<uint128_t>(a)
 
+using digit_t = big_integer::digit_t;
+
+// числа, построенные из a, наследуют его аллокатор, только если его задал пользователь.
+// Пул и арена выбираются заново, чтобы временные внутри limb_arena::scope попадали в арену
+static big_integer::allocator_type result_allocator(big_integer const &a) {
+	std::pmr::memory_resource *r = a.get_allocator().resource();
+	if (r == limb_pool::resource() || limb_arena::is_scope_resource(r)) {
+		return big_integer::default_allocator();
+	}
+	return a.get_allocator();
+}
+
 big_integer::big_integer()
-	: big_integer(0) {}
+	: big_integer(default_allocator()) {}
 
-big_integer::big_integer(big_integer const &other) = default;
+// ноль -- пустой вектор, поэтому конструктор по умолчанию не выделяет памяти
+big_integer::big_integer(allocator_type const &alloc)
+	: value(alloc), inf_1_after_last_digit(false) {}
 
-big_integer::big_integer(int a)
-	: value(1, std::abs(static_cast<int64_t>(a))), inf_1_after_last_digit(false) {
-	if (a < 0) {
-		*this = -(*this);
+big_integer::big_integer(big_integer const &other)
+	: big_integer(other, result_allocator(other)) {}
+
+big_integer::big_integer(big_integer const &other, allocator_type const &alloc)
+	: value(other.value, alloc), inf_1_after_last_digit(other.inf_1_after_last_digit) {}
+
+// у перемещённого объекта остаётся пустой вектор, то есть ноль
+big_integer::big_integer(big_integer &&other) noexcept
+	: value(std::move(other.value)), inf_1_after_last_digit(other.inf_1_after_last_digit) {
+	other.value.clear();
+	other.inf_1_after_last_digit = false;
+}
+
+big_integer::big_integer(int a, allocator_type const &alloc)
+	: value(alloc), inf_1_after_last_digit(a < 0) {
+	if (a != 0 && a != -1) {
+		value.push_back(to32(a));
 	}
 }
 
-big_integer::big_integer(uint32_t a)
-	: value(1, a), inf_1_after_last_digit(false) {}
+big_integer::big_integer(uint32_t a, allocator_type const &alloc)
+	: value(alloc), inf_1_after_last_digit(false) {
+	if (a != 0) {
+		value.push_back(a);
+	}
+}
 
-big_integer::big_integer(uint64_t a)
-	: value(1, to32(a % BASE)), inf_1_after_last_digit(false) {
-	value.push_back(to32(a / BASE));
-	shrink_to_fit();
+big_integer::big_integer(uint64_t a, allocator_type const &alloc)
+	: value(alloc), inf_1_after_last_digit(false) {
+	if (a != 0) {
+		value.assign({to32(a % BASE), to32(a / BASE)});
+		normalize();
+	}
 }
 
-big_integer::big_integer(uint128_t a)
-	: inf_1_after_last_digit(false) {
+big_integer::big_integer(uint128_t a, allocator_type const &alloc)
+	: value(alloc), inf_1_after_last_digit(false) {
 	do {
 		value.push_back(a % BASE128);
 		a /= BASE128;
 	} while (a > 0);
-	shrink_to_fit();
+	normalize();
 }
 
-big_integer::big_integer(std::string const &str)
-	: big_integer() {
+big_integer::big_integer(std::string const &str, allocator_type const &alloc)
+	: big_integer(alloc) {
 	if (str.empty()) {
 		return;
 	}
 	size_t i = 0;
 	if (str[i] == '-') i++;
-	for (; i < str.length(); ++i) {
-		if (str[i] < '0' || str[i] > '9') throw;
-		*this *= 10;
-		*this += to_digit(str[i] - '0');
+	// по 9 цифр за раз: *this = *this * 10^k + chunk
+	while (i < str.length()) {
+		digit_t chunk = 0, scale = 1;
+		for (size_t k = 0; k < 9 && i < str.length(); ++k, ++i) {
+			if (str[i] < '0' || str[i] > '9') throw;
+			chunk = chunk * 10 + to_digit(str[i] - '0');
+			scale *= 10;
+		}
+		*this *= scale;
+		*this += chunk;
 	}
 	if (str[0] == '-') {
-		*this = -(*this);
+		negate();
 	}
 }
 
 big_integer::~big_integer() = default;
 
+big_integer::allocator_type big_integer::get_allocator() const {
+	return value.get_allocator();
+}
+
+big_integer::allocator_type big_integer::default_allocator() {
+	std::pmr::memory_resource *arena = limb_arena::resource();
+	return allocator_type(arena != nullptr ? arena : limb_pool::resource());
+}
+
 uint32_t big_integer::get(size_t i) const {
 	if (i < value.size()) {
 		return value[i];
@@ -72,15 +127,40 @@ uint32_t big_integer::get_inf_digit() const {
 	return inf_1_after_last_digit ? MAX_DIGIT : MIN_DIGIT;
 }
 
-// удаляет лишние старшие цифры, которые состоят из одних нулей или единиц и совпадают с бесконечными условными лимбами
-void big_integer::shrink_to_fit() {
-	while (value.size() > 1) {
-		if ((value.back() == MIN_DIGIT && !inf_1_after_last_digit)
-			|| (value.back() == MAX_DIGIT && inf_1_after_last_digit)) {
-			value.pop_back();
-		} else {
-			return;
-		}
+// удаляет лишние старшие цифры, которые состоят из одних нулей или единиц и совпадают с бесконечными условными лимбами;
+// 0 и -1 остаются вовсе без лимбов. Ёмкость при этом не меняется
+void big_integer::normalize() {
+	value.resize(size());
+}
+
+// лимбы |*this| без ведущих нулей: для неотрицательного числа -- его собственные,
+// для отрицательного -- копия в scratch (до size() + 1 лимбов)
+big_integer::digit_t const *big_integer::magnitude(scratch_space::frame &frame, size_t &n) const {
+	if (!inf_1_after_last_digit) {
+		n = size();
+		return value.data();
+	}
+	digit_t *res = frame.alloc(size() + 1);
+	uint64_t carry = 1;
+	for (size_t i = 0; i < size(); ++i) {
+		carry += to64(~value[i]);
+		res[i] = to32(carry);
+		carry >>= 32u;
+	}
+	res[size()] = to32(carry);
+	n = size() + 1;
+	while (n > 0 && res[n - 1] == 0) {
+		n--;
+	}
+	return res;
+}
+
+// *this = (negative ? -mag : mag); mag не должен указывать в собственные лимбы
+void big_integer::assign_magnitude(digit_t const *mag, size_t n, bool negative) {
+	value.assign(mag, mag + n);
+	inf_1_after_last_digit = false;
+	if (negative) {
+		negate();
 	}
 }
 
@@ -93,24 +173,76 @@ big_integer &big_integer::operator=(big_integer const &rhs) {
 	return *this;
 }
 
-big_integer &big_integer::operator+=(big_integer const &b) {
-	size_t size_ = std::max(size(), b.size());
+// при общем аллокаторе буферы меняются местами, и старый буфер освободит rhs
+big_integer &big_integer::operator=(big_integer &&rhs) {
+	if (this == &rhs) {
+		return *this;
+	}
+	if (get_allocator() != rhs.get_allocator()) {
+		return *this = rhs;
+	}
+	value.swap(rhs.value);
+	std::swap(inf_1_after_last_digit, rhs.inf_1_after_last_digit);
+	return *this;
+}
+
+// v[0..k) += (ones ? B^k - 1 : 0) + c, возвращает перенос
+static digit_t add_tail(digit_t *v, size_t k, bool ones, digit_t c) {
+	if (!ones) {
+		return limb_kernels::add_1(v, v, k, c);
+	}
+	// v + B^k - 1 + 1 == v + B^k: лимбы не меняются, перенос уходит наверх
+	if (c == 1 || k == 0) {
+		return c;
+	}
+	return 1 - limb_kernels::sub_1(v, v, k, 1);
+}
+
+// *this += (invert ? ~b : b) + carry_in за один проход, где b -- лимбы b[0..bn) и бесконечный хвост b_inf;
+// b может указывать в собственные лимбы. Общие лимбы складываются (или вычитаются) ядром add_n / sub_n,
+// выше более короткого операнда к лимбам длинного прибавляется только знаковый хвост короткого
+void big_integer::add_limbs(digit_t const *b, size_t bn, bool b_inf, bool invert, uint32_t carry_in) {
+	bool self = b == value.data();
+	size_t n = size();
+	size_t size_ = std::max(n, bn);
 	value.resize(size_, get_inf_digit());
-	uint64_t sum = 0, carry = 0;
-	for (size_t i = 0; i < size_; ++i) {
-		sum = to64(get(i)) + to64(b.get(i)) + carry;
-		value[i] = to_digit(sum % BASE);
-		carry = sum / BASE;
+	if (self) {
+		b = value.data();
 	}
+	digit_t *v = value.data();
+	size_t common = std::min(n, bn);
+	digit_t carry;
+	if (!invert) {
+		carry = limb_kernels::add_n(v, v, b, common);
+		if (carry_in != 0) {
+			carry += limb_kernels::add_1(v, v, common, 1);
+		}
+	} else {
+		// v + ~b + carry_in == v - b - 1 + carry_in + B^common
+		digit_t borrow = limb_kernels::sub_n(v, v, b, common);
+		if (carry_in == 0) {
+			borrow += limb_kernels::sub_1(v, v, common, 1);
+		}
+		carry = 1 - borrow;
+	}
+	if (n >= bn) {
+		carry = add_tail(v + bn, n - bn, b_inf != invert, carry);
+	} else {
+		if (invert) {
+			limb_kernels::com(v + n, b + n, bn - n);
+		} else {
+			std::copy(b + n, b + bn, v + n);
+		}
+		carry = add_tail(v + n, bn - n, inf_1_after_last_digit, carry);
+	}
+	b_inf = b_inf != invert;
 	// теперь решим вопрос с бесконечными единицами, нулями и carry
-	bool one_is_1 = (inf_1_after_last_digit && !b.inf_1_after_last_digit)
-		|| (!inf_1_after_last_digit && b.inf_1_after_last_digit);
-	if ((!inf_1_after_last_digit && !b.inf_1_after_last_digit && carry == 0) || (one_is_1 && carry > 0)) {
+	bool one_is_1 = (inf_1_after_last_digit && !b_inf) || (!inf_1_after_last_digit && b_inf);
+	if ((!inf_1_after_last_digit && !b_inf && carry == 0) || (one_is_1 && carry > 0)) {
 		inf_1_after_last_digit = false;
-	} else if ((one_is_1 && carry == 0) || (inf_1_after_last_digit && b.inf_1_after_last_digit && carry > 0)) {
+	} else if ((one_is_1 && carry == 0) || (inf_1_after_last_digit && b_inf && carry > 0)) {
 		inf_1_after_last_digit = true;
-	} else if (inf_1_after_last_digit && b.inf_1_after_last_digit
-		&& carry == 0) {  // a.inf_1_after_last_digit and b.inf_1_after_last_digit
+	} else if (inf_1_after_last_digit && b_inf && carry == 0) {  // a.inf_1_after_last_digit and b.inf_1_after_last_digit
 		value.resize(size_ + 1);
 		value[size_] = MAX_DIGIT - 1;
 		inf_1_after_last_digit = true;
@@ -119,58 +251,94 @@ big_integer &big_integer::operator+=(big_integer const &b) {
 		value[size_] = MIN_DIGIT + 1;
 		inf_1_after_last_digit = false;
 	}
-	shrink_to_fit();
-	return *this;
+}
 
+void big_integer::add_with_carry(big_integer const &b, bool invert, uint32_t carry_in) {
+	add_limbs(b.value.data(), b.size(), b.inf_1_after_last_digit, invert, carry_in);
+}
+
+big_integer &big_integer::operator+=(big_integer const &b) {
+	add_with_carry(b, false, 0);
+	return *this;
 }
 
 big_integer &big_integer::operator-=(big_integer const &rhs) {
-	return *this += -rhs;
+	// a - b == a + ~b + 1
+	add_with_carry(rhs, true, 1);
+	return *this;
 }
 
-big_integer big_integer::naive_mul(big_integer const &b) {
-	big_integer res;
-	res.value.resize(size() + b.size(), 0u);
-	for (size_t i = 0; i < size(); ++i) {
-		uint64_t sum = 0, carry = 0;
-		for (size_t j = 0; j < b.size() || carry > 0; ++j) {
-			sum = res.get(i + j) + carry +
-				to64(get(i)) * to64(b.get(j));
-			res.value[i + j] = to32(sum % BASE);
-			carry = sum / BASE;
+// прибавляет (borrow ? -c : c) к лимбам начиная с from; перенос бежит только до первого лимба без переполнения,
+// а выход за старший лимб разрешается через бесконечный хвост
+void big_integer::ripple(size_t from, digit_t c, bool borrow) {
+	if (c == 0) {
+		return;
+	}
+	digit_t *p = value.data() + from;
+	size_t n = value.size() - from;
+	digit_t out = borrow ? limb_kernels::sub_1(p, p, n, c) : limb_kernels::add_1(p, p, n, c);
+	if (out != 0) {
+		if (borrow != inf_1_after_last_digit) {
+			// ...1111 + 1 == 0, 0 - 1 == ...1111
+			inf_1_after_last_digit = !inf_1_after_last_digit;
+		} else {
+			value.push_back(borrow ? MAX_DIGIT - 1 : MIN_DIGIT + 1);
 		}
 	}
-	res.shrink_to_fit();
-	return *this = res;
+}
+
+// *this += bits - (negative ? 2^64 : 0)
+void big_integer::add_native(uint64_t bits, bool negative) {
+	value.resize(std::max(size(), static_cast<size_t>(2)), get_inf_digit());
+	digit_t b[2] = {to32(bits), to32(bits >> 32u)};
+	digit_t carry = limb_kernels::add_n(value.data(), value.data(), b, 2);
+	if (negative) {
+		// к старшим лимбам прибавляется carry - 1
+		ripple(2, 1 - carry, true);
+	} else {
+		ripple(2, carry, false);
+	}
+}
+
+big_integer big_integer::naive_mul(big_integer const &b) {
+	mul(*this, *this, b);
+	return *this;
 }
 
 big_integer &big_integer::operator*=(big_integer const &rhs) {
-	bool sign = (inf_1_after_last_digit && !rhs.inf_1_after_last_digit)
-		|| (!inf_1_after_last_digit && rhs.inf_1_after_last_digit);
-	if (inf_1_after_last_digit) *this = -(*this);
-	naive_mul(rhs.inf_1_after_last_digit ? -rhs : rhs);
-	if (sign) {
-		*this = -(*this);
-	}
-	shrink_to_fit();
+	mul(*this, *this, rhs);
 	return *this;
 }
 
-big_integer big_integer::div_by_short(digit_t val) {
-	if (val == 0) {
-		throw std::runtime_error("division by zero");
+void big_integer::mul_native(uint64_t bits, bool negative) {
+	uint64_t m = negative ? 0 - bits : bits;
+	if (m == 0) {
+		value.clear();
+		inf_1_after_last_digit = false;
+		return;
 	}
-	if (*this == 0) {
-		return 0;
+	if (m >= BASE) {
+		scratch_space::frame frame;
+		size_t n;
+		digit_t const *x = magnitude(frame, n);
+		digit_t y[2] = {to32(m), to32(m >> 32u)};
+		digit_t *p = frame.alloc(n + 2);
+		limb_kernels::mul_basecase(p, x, n, y, 2);
+		assign_magnitude(p, n + 2, inf_1_after_last_digit != negative);
+		return;
 	}
-	uint32_t carry = 0;
-	for (size_t i = size(); i > 0; --i) {
-		uint64_t tmp = (to64(carry) << 32u) + value[i - 1];
-		value[i - 1] = tmp / val;
-		carry = tmp % val;
+	// одним проходом по месту; отрицательное число -- это L - BASE^n, и старший лимб получает ещё -m.
+	// Лишние лимбы отрезаются заранее, иначе каждое умножение добавляло бы по одному
+	normalize();
+	digit_t hi = limb_kernels::mul_1(value.data(), value.data(), size(), to32(m));
+	value.push_back(inf_1_after_last_digit ? hi - to32(m) : hi);
+	if (negative) {
+		negate();
 	}
-	shrink_to_fit();
-	return *this;
+}
+
+big_integer big_integer::div_by_short(digit_t val) {
+	return *this /= divisor(val);
 }
 
 big_integer big_integer::div128(big_integer const &rhs) {
@@ -182,142 +350,223 @@ big_integer big_integer::div128(big_integer const &rhs) {
 	return *this = a / b;
 }
 
-using digit_t = uint32_t;
-static digit_t div_3_by_2(digit_t a, digit_t b, digit_t c, digit_t x, digit_t y) {
-	uint128_t l, r;
-	l = to128(c) + (to128(b) << 32ull) + (to128(a) << 64ull);
-	r = to128(y) + (to128(x) << 32ull);
-	return l / r;
+
+// деление столбиком (алгоритм D из Кнута) над сырыми лимбами: u[0..un) / d[0..dn),
+// dn >= 2, un >= dn, d[dn - 1] != 0; частное -- un - dn + 1 лимбов в q, остаток -- dn лимбов в r.
+// q и r могут быть nullptr, если не нужны; вся временная память берётся из scratch_space
+static void divmod_limbs(digit_t *q, digit_t *r, digit_t const *u_, size_t un, digit_t const *d_, size_t dn) {
+	scratch_space::frame frame;
+	digit_t *u = frame.alloc(un + 1);
+	digit_t *d = frame.alloc(dn);
+	// нормализуем делитель так, чтобы старший бит старшего лимба был единицей
+	uint32_t shift = __builtin_clz(d_[dn - 1]);
+	limb_kernels::lshift(d, d_, dn, shift);
+	u[un] = limb_kernels::lshift(u, u_, un, shift);
+
+	for (size_t j = un - dn + 1; j-- > 0;) {
+		uint64_t num = (to64(u[j + dn]) << 32u) | u[j + dn - 1];
+		uint64_t qhat = num / d[dn - 1];
+		uint64_t rhat = num % d[dn - 1];
+		while (qhat >= big_integer::BASE || qhat * d[dn - 2] > ((rhat << 32u) | u[j + dn - 2])) {
+			qhat--;
+			rhat += d[dn - 1];
+			if (rhat >= big_integer::BASE) {
+				break;
+			}
+		}
+		// u[j..j + dn] -= qhat * d
+		digit_t borrow = limb_kernels::submul_1(u + j, d, dn, to32(qhat));
+		bool negative = u[j + dn] < borrow;
+		u[j + dn] -= borrow;
+		if (negative) {
+			// qhat оказался на единицу больше -- возвращаем d обратно
+			qhat--;
+			u[j + dn] += limb_kernels::add_n(u + j, u + j, d, dn);
+		}
+		if (q != nullptr) {
+			q[j] = to32(qhat);
+		}
+	}
+
+	if (r != nullptr) {
+		limb_kernels::rshift(r, u, dn, shift);
+		if (shift != 0) {
+			r[dn - 1] |= u[dn] << (32 - shift);
+		}
+	}
 }
 
-static bool normalised(digit_t a) {
-	return (a & (1u << 31u)) > 0;
+// деление с округлением к нулю: q = a / b, r = a % b; q или r может быть nullptr,
+// любой из результатов может совпадать с a или b
+void big_integer::divide(big_integer *q, big_integer *r, big_integer const &a, big_integer const &b) {
+	scratch_space::frame frame;
+	size_t dn;
+	digit_t const *d = b.magnitude(frame, dn);
+	divide(q, r, a, d, dn, b.inf_1_after_last_digit);
 }
 
-big_integer big_integer::limb_div(big_integer const &rhs) {
-	if (rhs == 0) {
+// то же, но делитель задан модулем d[0..dn) без ведущих нулей и знаком
+void big_integer::divide(big_integer *q, big_integer *r, big_integer const &a, digit_t const *d, size_t dn,
+                         bool d_negative) {
+	scratch_space::frame frame;
+	size_t un;
+	digit_t const *u = a.magnitude(frame, un);
+	if (dn == 0) {
 		throw std::runtime_error("division by zero");
 	}
-	if (*this < rhs) {
-		return *this = 0;
-	}
-	if (*this == rhs) {
-		return *this = 1;
+	size_t qn = un >= dn ? un - dn + 1 : 1;
+	// divisor::divrem пишет все un лимбов частного, в том числе старший нулевой при dn == 2
+	digit_t *qs = frame.alloc(dn <= 2 ? std::max(qn, un) : qn);
+	digit_t *rs = frame.alloc(dn);
+	if (un < dn || (un == dn && limb_kernels::cmp_n(u, d, un) < 0)) {
+		qs[0] = 0;
+		std::fill(rs, rs + dn, 0);
+		std::copy(u, u + un, rs);
+	} else if (dn <= 2) {
+		// обратная величина окупается уже на нескольких лимбах частного
+		uint64_t rem = divisor(to64(d[0]) | (dn == 2 ? to64(d[1]) << 32u : 0)).divrem(qs, u, un);
+		rs[0] = to32(rem);
+		if (dn == 2) {
+			rs[1] = to32(rem >> 32u);
+		}
+	} else {
+		divmod_limbs(qs, rs, u, un, d, dn);
 	}
-	if (rhs.size() == 1) {
-		return div_by_short(rhs.value[0]);
+	bool a_negative = a.inf_1_after_last_digit;
+	if (q != nullptr) {
+		q->assign_magnitude(qs, qn, a_negative != d_negative);
 	}
-	if (size() <= 4) {
-		return div128(rhs);
+	if (r != nullptr) {
+		r->assign_magnitude(rs, dn, a_negative);
 	}
+}
 
-	big_integer u = *this;
-	big_integer d = rhs;
-	int shift = 0;
-	while (!normalised(d.value.back())) {
-		d <<= 1;
-		shift++;
-	}
-	if (shift > 0) {
-		return (*this <<= shift) /= d;
+void big_integer::divide_native(uint64_t bits, bool negative, bool remainder) {
+	uint64_t m = negative ? 0 - bits : bits;
+	if (m == 0) {
+		throw std::runtime_error("division by zero");
 	}
+	big_integer *q = remainder ? nullptr : this;
+	big_integer *r = remainder ? this : nullptr;
+	divide(q, r, *this, divisor(m), negative);
+}
 
-	ssize_t m = u.size(), n = d.size();
-	ssize_t k = m - n;
-	big_integer q, dbk = d << (32 * static_cast<int>(k));
-	q.value.resize(k + 1, 0);
-	if (u >= dbk) {
-		q.value[k] = 1;
-		u -= dbk;
-	} else {
-		q.value[k] = 0;
-	}
-	while (k > 0) {
-		dbk >>= 32;
-		k--;
-		if (u.get(n + k) == d.get(n - 1) && u.get(n + k - 1) == d.get(n - 2)) {
-			q.value[k] = MAX_DIGIT;
+// деление на делитель из одного-двух лимбов; неотрицательное делимое делится по месту одним проходом
+void big_integer::divide(big_integer *q, big_integer *r, big_integer const &a, divisor const &d, bool d_negative) {
+	bool a_negative = a.inf_1_after_last_digit;
+	uint64_t rem;
+	if (!a_negative && (q == nullptr || (q == &a && r != &a))) {
+		if (q == nullptr) {
+			scratch_space::frame frame;
+			rem = d.divrem(frame.alloc(a.size()), a.value.data(), a.size());
 		} else {
-			q.value[k] = div_3_by_2(u.get(n + k), u.get(n + k - 1), u.get(n + k - 2),
-									d.get(n - 1), d.get(n - 2));
+			rem = d.divrem(q->value.data(), q->value.data(), q->size());
+			if (d_negative) {
+				q->negate();
+			}
 		}
-		u -= q.value[k] * dbk;
-		if (u < 0) {
-			u += d;
-			q.value[k]--;
+	} else {
+		scratch_space::frame frame;
+		size_t un;
+		digit_t const *u = a.magnitude(frame, un);
+		digit_t *qs = frame.alloc(un);
+		rem = d.divrem(qs, u, un);
+		if (q != nullptr) {
+			q->assign_magnitude(qs, un, a_negative != d_negative);
 		}
 	}
-	q.shrink_to_fit();
-	return *this = q;
+	if (r != nullptr) {
+		digit_t rs[2] = {to32(rem), to32(rem >> 32u)};
+		r->assign_magnitude(rs, 2, a_negative);
+	}
 }
 
-big_integer &big_integer::operator/=(big_integer const &rhs) {
-	bool sign = (inf_1_after_last_digit && !rhs.inf_1_after_last_digit)
-		|| (!inf_1_after_last_digit && rhs.inf_1_after_last_digit);
-	if (inf_1_after_last_digit) *this = -(*this);
+big_integer &big_integer::operator/=(divisor const &rhs) {
+	divide(this, nullptr, *this, rhs, false);
+	return *this;
+}
 
-	limb_div(rhs.inf_1_after_last_digit ? -rhs : rhs);
-	if (sign) {
-		*this = -(*this);
-	}
+big_integer &big_integer::operator%=(divisor const &rhs) {
+	divide(nullptr, this, *this, rhs, false);
+	return *this;
+}
+
+big_integer big_integer::limb_div(big_integer const &rhs) {
+	divide(this, nullptr, *this, rhs);
+	return *this;
+}
+
+big_integer &big_integer::limb_mod(big_integer const &rhs) {
+	divide(nullptr, this, *this, rhs);
+	return *this;
+}
 
-	shrink_to_fit();
+big_integer &big_integer::operator/=(big_integer const &rhs) {
+	divide(this, nullptr, *this, rhs);
 	return *this;
 }
 
 big_integer &big_integer::operator%=(big_integer const &rhs) {
-	return *this = *this - ((*this / rhs) * rhs);
+	// остаток берёт знак делимого, как у встроенных типов
+	divide(nullptr, this, *this, rhs);
+	return *this;
 }
 
+// Общие младшие лимбы обрабатывает векторное ядро. Выше более короткого операнда идут только его
+// знаковые биты, так что лимбы длинного операнда там копируются, инвертируются или отбрасываются целиком
+// лишние лимбы *this отрезаются заранее: у результата над ними уже другой знаковый хвост
 big_integer &big_integer::operator&=(big_integer const &rhs) {
-	size_t size_ = std::max(size(), rhs.size());
-	value.resize(size_, get_inf_digit());
-	for (size_t i = 0; i < size_; ++i) {
-		value[i] = get(i) & rhs.get(i);
+	normalize();
+	size_t n = size(), m = rhs.size();
+	if (n < m && inf_1_after_last_digit) {
+		value.resize(m);
+		std::copy(rhs.value.begin() + n, rhs.value.begin() + m, value.begin() + n);
+	} else if (n > m && !rhs.inf_1_after_last_digit) {
+		value.resize(m);
 	}
+	limb_kernels::and_n(value.data(), value.data(), rhs.value.data(), std::min(n, m));
 	inf_1_after_last_digit = inf_1_after_last_digit && rhs.inf_1_after_last_digit;
-	shrink_to_fit();
 	return *this;
 }
 
 big_integer &big_integer::operator|=(big_integer const &rhs) {
-	size_t size_ = std::max(size(), rhs.size());
-	value.resize(size_, get_inf_digit());
-	for (size_t i = 0; i < size_; ++i) {
-		value[i] = get(i) | rhs.get(i);
+	normalize();
+	size_t n = size(), m = rhs.size();
+	if (n < m && !inf_1_after_last_digit) {
+		value.resize(m);
+		std::copy(rhs.value.begin() + n, rhs.value.begin() + m, value.begin() + n);
+	} else if (n > m && rhs.inf_1_after_last_digit) {
+		value.resize(m);
 	}
+	limb_kernels::ior_n(value.data(), value.data(), rhs.value.data(), std::min(n, m));
 	inf_1_after_last_digit = inf_1_after_last_digit || rhs.inf_1_after_last_digit;
-	shrink_to_fit();
 	return *this;
 }
 
 big_integer &big_integer::operator^=(big_integer const &rhs) {
-	size_t size_ = std::max(size(), rhs.size());
-	value.resize(size_, get_inf_digit());
-	for (size_t i = 0; i < size_; ++i) {
-		value[i] = get(i) ^ rhs.get(i);
+	normalize();
+	size_t n = size(), m = rhs.size();
+	if (n < m) {
+		value.resize(m);
+		if (inf_1_after_last_digit) {
+			limb_kernels::com(value.data() + n, rhs.value.data() + n, m - n);
+		} else {
+			std::copy(rhs.value.begin() + n, rhs.value.begin() + m, value.begin() + n);
+		}
+	} else if (n > m && rhs.inf_1_after_last_digit) {
+		limb_kernels::com(value.data() + m, value.data() + m, n - m);
 	}
-	inf_1_after_last_digit = (!inf_1_after_last_digit && rhs.inf_1_after_last_digit)
-		|| (inf_1_after_last_digit && !rhs.inf_1_after_last_digit);
-	shrink_to_fit();
+	limb_kernels::xor_n(value.data(), value.data(), rhs.value.data(), std::min(n, m));
+	inf_1_after_last_digit = inf_1_after_last_digit != rhs.inf_1_after_last_digit;
 	return *this;
 }
 
 big_integer &big_integer::operator<<=(int rhs) {
-	if (rhs < 0) return *this >>= -rhs;
-	block_shl(static_cast<size_t>(rhs) / 32);
-	uint32_t c = rhs % 32;
-	if (c == 0) {
-		return *this;
-	}
-	uint32_t d = (32 - c) % 32;
-	value.resize(size() + 1, get_inf_digit());
-	for (size_t i = size() - 1; i > 0; --i) {
-		value[i] <<= c;
-		value[i] |= (value[i - 1] >> d);
+	if (rhs < 0) {
+		shr(*this, *this, -static_cast<int64_t>(rhs));
+	} else {
+		shl(*this, *this, rhs);
 	}
-	value[0] <<= c;
-	shrink_to_fit();
 	return *this;
 }
 
@@ -325,38 +574,71 @@ big_integer big_integer::operator+() const {
 	return *this;
 }
 
-big_integer big_integer::operator-() const {
-	return ++(~(*this));
+big_integer big_integer::operator-() const & {
+	big_integer res(*this);
+	res.negate();
+	return res;
+}
+
+big_integer big_integer::operator-() && {
+	negate();
+	return std::move(*this);
+}
+
+// -x == ~x + 1: перенос от +1 бежит по младшим лимбам, пока они нулевые, остальные лимбы просто инвертируются
+void big_integer::negate() {
+	size_t n = value.size();
+	size_t i = 0;
+	while (i < n && value[i] == 0) {
+		i++;
+	}
+	inf_1_after_last_digit = !inf_1_after_last_digit;
+	if (i == n) {
+		// все лимбы нулевые: перенос уходит в бесконечный хвост
+		if (inf_1_after_last_digit) {
+			inf_1_after_last_digit = false;
+		} else {
+			value.push_back(MIN_DIGIT + 1);
+		}
+		return;
+	}
+	value[i] = ~value[i] + 1;
+	for (++i; i < n; ++i) {
+		value[i] = ~value[i];
+	}
 }
 
 big_integer &big_integer::operator>>=(int rhs) {
-	if (rhs < 0) return *this <<= -rhs;
-	block_shr(static_cast<size_t>(rhs) / 32);
-	uint32_t c = rhs % 32;
-	if (c == 0) return *this;
-	uint32_t d = (32 - c) % 32;  // ?
-	value.resize(size() + 1, get_inf_digit());
-	for (size_t i = 0; i < size() - 1; ++i) {
-		value[i] >>= c;
-		value[i] |= (value[i + 1] << d);
-	}
-//	res.value[res.size() - 1] >>= c;  не требуется, так как этот блок равен всем слудующим (все нули или все единицы)
-	shrink_to_fit();
+	if (rhs < 0) {
+		shl(*this, *this, -static_cast<int64_t>(rhs));
+	} else {
+		shr(*this, *this, rhs);
+	}
 	return *this;
 }
 
-big_integer big_integer::operator~() const {
-	big_integer res(*this);
-	for (digit_t &digit : res.value) {
-		digit = ~digit;
-	}
-	res.inf_1_after_last_digit = !res.inf_1_after_last_digit;
-	res.shrink_to_fit();
+// ~*this на месте
+void big_integer::flip_bits() {
+	limb_kernels::com(value.data(), value.data(), value.size());
+	inf_1_after_last_digit = !inf_1_after_last_digit;
+}
+
+big_integer big_integer::operator~() && {
+	flip_bits();
+	return std::move(*this);
+}
+
+big_integer big_integer::operator~() const & {
+	big_integer res(result_allocator(*this));
+	res.value.resize(size());
+	limb_kernels::com(res.value.data(), value.data(), size());
+	res.inf_1_after_last_digit = !inf_1_after_last_digit;
 	return res;
 }
 
 big_integer &big_integer::operator++() {
-	return *this += 1;
+	ripple(0, 1, false);
+	return *this;
 }
 
 big_integer big_integer::operator++(int) {
@@ -366,7 +648,8 @@ big_integer big_integer::operator++(int) {
 }
 
 big_integer &big_integer::operator--() {
-	return *this -= 1;
+	ripple(0, 1, true);
+	return *this;
 }
 
 big_integer big_integer::operator--(int) {
@@ -387,10 +670,143 @@ big_integer operator*(big_integer a, big_integer const &b) {
 	return a *= b;
 }
 
+size_t big_integer::capacity() const {
+	return value.capacity();
+}
+
+void big_integer::reserve(size_t limbs) {
+	value.reserve(limbs);
+}
+
+void big_integer::shrink_to_fit() {
+	normalize();
+	value.shrink_to_fit();
+}
+
+// результат можно строить в буфере правого операнда, только если он живёт в памяти левого
+static bool can_steal(big_integer const &a, big_integer const &b) {
+	return a.get_allocator() == b.get_allocator();
+}
+
+// оба операнда временные: берём тот, у кого буфер больше
+static bool prefer_right(big_integer const &a, big_integer const &b) {
+	return b.capacity() > a.capacity() && can_steal(a, b);
+}
+
+big_integer operator+(big_integer const &a, big_integer &&b) {
+	if (!can_steal(a, b)) {
+		return big_integer(a) += b;
+	}
+	b += a;
+	return std::move(b);
+}
+
+big_integer operator+(big_integer &&a, big_integer &&b) {
+	if (prefer_right(a, b)) {
+		b += a;
+		return std::move(b);
+	}
+	a += b;
+	return std::move(a);
+}
+
+big_integer operator-(big_integer const &a, big_integer &&b) {
+	if (!can_steal(a, b)) {
+		return big_integer(a) -= b;
+	}
+	sub(b, a, b);
+	return std::move(b);
+}
+
+big_integer operator-(big_integer &&a, big_integer &&b) {
+	if (prefer_right(a, b)) {
+		sub(b, a, b);
+		return std::move(b);
+	}
+	a -= b;
+	return std::move(a);
+}
+
+big_integer operator*(big_integer const &a, big_integer &&b) {
+	if (!can_steal(a, b)) {
+		return big_integer(a) *= b;
+	}
+	mul(b, a, b);
+	return std::move(b);
+}
+
+big_integer operator*(big_integer &&a, big_integer &&b) {
+	if (prefer_right(a, b)) {
+		mul(b, a, b);
+		return std::move(b);
+	}
+	a *= b;
+	return std::move(a);
+}
+
+big_integer operator&(big_integer const &a, big_integer &&b) {
+	if (!can_steal(a, b)) {
+		return big_integer(a) &= b;
+	}
+	b &= a;
+	return std::move(b);
+}
+
+big_integer operator&(big_integer &&a, big_integer &&b) {
+	if (prefer_right(a, b)) {
+		b &= a;
+		return std::move(b);
+	}
+	a &= b;
+	return std::move(a);
+}
+
+big_integer operator|(big_integer const &a, big_integer &&b) {
+	if (!can_steal(a, b)) {
+		return big_integer(a) |= b;
+	}
+	b |= a;
+	return std::move(b);
+}
+
+big_integer operator|(big_integer &&a, big_integer &&b) {
+	if (prefer_right(a, b)) {
+		b |= a;
+		return std::move(b);
+	}
+	a |= b;
+	return std::move(a);
+}
+
+big_integer operator^(big_integer const &a, big_integer &&b) {
+	if (!can_steal(a, b)) {
+		return big_integer(a) ^= b;
+	}
+	b ^= a;
+	return std::move(b);
+}
+
+big_integer operator^(big_integer &&a, big_integer &&b) {
+	if (prefer_right(a, b)) {
+		b ^= a;
+		return std::move(b);
+	}
+	a ^= b;
+	return std::move(a);
+}
+
 big_integer operator/(big_integer lhs, big_integer const &rhs) {
 	return lhs /= rhs;
 }
 
+big_integer operator/(big_integer a, divisor const &b) {
+	return a /= b;
+}
+
+big_integer operator%(big_integer a, divisor const &b) {
+	return a %= b;
+}
+
 big_integer operator%(big_integer a, big_integer const &b) {
 	return a %= b;
 }
@@ -407,33 +823,179 @@ big_integer operator^(big_integer a, big_integer const &b) {
 	return a ^= b;
 }
 
-void big_integer::block_shl(size_t cnt) {
-	std::vector<digit_t> new_value(cnt, 0);
-	for (digit_t &digit : value) {
-		new_value.push_back(digit);
+// Размер результата известен заранее: сдвиг на целые лимбы и на биты внутри лимба делаются
+// одним проходом lshift со смещением назначения. При res == a лимбы двигаются к старшим,
+// а lshift идёт сверху вниз, так что ещё не прочитанные лимбы не затираются
+void shl(big_integer &res, big_integer const &a, size_t k) {
+	bool negative = a.inf_1_after_last_digit;
+	size_t n = a.size();
+	if (n == 0 && !negative) {
+		res.value.clear();
+		res.inf_1_after_last_digit = false;
+		return;
+	}
+	size_t blocks = k / 32;
+	unsigned c = k % 32;
+	size_t m = n + blocks + (c != 0 ? 1 : 0);
+	big_integer::digit_t inf = a.get_inf_digit();
+	res.value.resize(m);
+	big_integer::digit_t *r = res.value.data();
+	big_integer::digit_t const *s = a.value.data();
+	big_integer::digit_t out = limb_kernels::lshift(r + blocks, s, n, c);
+	if (c != 0) {
+		r[m - 1] = out | (inf << c);
 	}
-	swap(value, new_value);
+	std::fill(r, r + blocks, 0);
+	res.inf_1_after_last_digit = negative;
 }
 
-void big_integer::block_shr(size_t cnt) {
-	if (cnt < value.size()) {
-		value.erase(value.begin(), value.begin() + cnt);
-	} else {
-		std::vector<digit_t> new_value(1, get(size()));
-		swap(value, new_value);
+// округление к минус бесконечности: сверху вдвигаются знаковые биты. При res == a лимбы
+// двигаются к младшим, а rshift идёт снизу вверх
+void shr(big_integer &res, big_integer const &a, size_t k) {
+	bool negative = a.inf_1_after_last_digit;
+	size_t n = a.size();
+	size_t blocks = k / 32;
+	unsigned c = k % 32;
+	if (blocks >= n) {
+		res.value.clear();
+		res.inf_1_after_last_digit = negative;
+		return;
 	}
+	size_t m = n - blocks;
+	big_integer::digit_t inf = a.get_inf_digit();
+	if (&res != &a) {
+		res.value.resize(m);
+	}
+	big_integer::digit_t *r = res.value.data();
+	big_integer::digit_t const *s = a.value.data();
+	limb_kernels::rshift(r, s + blocks, m, c);
+	if (c != 0) {
+		r[m - 1] |= inf << (32 - c);
+	}
+	res.value.resize(m);
+	res.inf_1_after_last_digit = negative;
 }
 
 big_integer operator<<(big_integer a, int b) {
-	return a <<= b;
+	a <<= b;
+	return a;
 }
 
 big_integer operator>>(big_integer a, int b) {
-	return a >>= b;
+	a >>= b;
+	return a;
 }
 
+// лишние лимбы лежат только сверху, так что проход останавливается на первом значащем
 size_t big_integer::size() const {
-	return value.size();
+	digit_t inf = get_inf_digit();
+	size_t n = value.size();
+	while (n > 0 && value[n - 1] == inf) {
+		n--;
+	}
+	return n;
+}
+
+size_t big_integer::bit_length() const {
+	size_t n = size();
+	if (n == 0) {
+		return 0;
+	}
+	digit_t top = value[n - 1] ^ get_inf_digit();
+	return 32 * n - __builtin_clz(top);
+}
+
+size_t big_integer::popcount() const {
+	size_t res = 0;
+	for (digit_t d : value) {
+		res += __builtin_popcount(d ^ get_inf_digit());
+	}
+	return res;
+}
+
+size_t big_integer::countr_zero() const {
+	size_t n = size();
+	for (size_t i = 0; i < n; i++) {
+		if (value[i] != 0) {
+			return 32 * i + __builtin_ctz(value[i]);
+		}
+	}
+	// все значащие лимбы нулевые: это 0 или -B^n, у которого первая единица -- в бесконечном хвосте
+	return inf_1_after_last_digit ? 32 * n : SIZE_MAX;
+}
+
+bool big_integer::test_bit(size_t k) const {
+	return (get(k / 32) >> (k % 32)) & 1u;
+}
+
+// лимб с битом k; если его ещё нет, число дополняется знаковыми лимбами
+big_integer::digit_t &big_integer::limb_with_bit(size_t k) {
+	if (k / 32 >= value.size()) {
+		value.resize(k / 32 + 1, get_inf_digit());
+	}
+	return value[k / 32];
+}
+
+void big_integer::set_bit(size_t k) {
+	if (!test_bit(k)) {
+		limb_with_bit(k) |= 1u << (k % 32);
+	}
+}
+
+void big_integer::clear_bit(size_t k) {
+	if (test_bit(k)) {
+		limb_with_bit(k) &= ~(1u << (k % 32));
+	}
+}
+
+void big_integer::flip_bit(size_t k) {
+	limb_with_bit(k) ^= 1u << (k % 32);
+}
+
+// как &=, только знаковый хвост mask берётся инвертированным
+void big_integer::clear_bits(big_integer const &mask) {
+	normalize();
+	size_t n = size(), m = mask.size();
+	if (n < m && inf_1_after_last_digit) {
+		value.resize(m);
+		limb_kernels::com(value.data() + n, mask.value.data() + n, m - n);
+	} else if (n > m && mask.inf_1_after_last_digit) {
+		value.resize(m);
+	}
+	limb_kernels::andn_n(value.data(), value.data(), mask.value.data(), std::min(n, m));
+	inf_1_after_last_digit = inf_1_after_last_digit && !mask.inf_1_after_last_digit;
+}
+
+big_integer big_integer::extract_bits(size_t pos, size_t len) const {
+	big_integer res(result_allocator(*this));
+	size_t first = pos / 32;
+	unsigned shift = pos % 32;
+	// за пределами лимбов у неотрицательного числа одни нули
+	if (len == 0 || (first >= size() && !inf_1_after_last_digit)) {
+		return res;
+	}
+	res.value.resize((len + 31) / 32);
+	for (size_t i = 0; i < res.value.size(); i++) {
+		uint64_t w = to64(get(first + i)) | (to64(get(first + i + 1)) << 32u);
+		res.value[i] = to_digit(w >> shift);
+	}
+	if (len % 32 != 0) {
+		res.value.back() &= (1u << (len % 32)) - 1;
+	}
+	return res;
+}
+
+// каноническое число из трёх и более лимбов по модулю не меньше 2^64 и больше любого 64-битного
+int big_integer::compare_native(uint64_t bits, bool negative) const {
+	if (inf_1_after_last_digit != negative) {
+		return inf_1_after_last_digit ? -1 : 1;
+	}
+	if (size() > 2) {
+		return inf_1_after_last_digit ? -1 : 1;
+	}
+	// знаки совпадают, так что младшие 64 бита сравниваются как беззнаковые
+	uint64_t low = to64(get(0)) | (to64(get(1)) << 32u);
+	return low < bits ? -1 : (low > bits ? 1 : 0);
 }
 
 int big_integer::compare_to(big_integer const &other) const {
@@ -455,6 +1017,584 @@ int big_integer::compare_to(big_integer const &other) const {
 	return res;
 }
 
+void add(big_integer &res, big_integer const &a, big_integer const &b) {
+	if (&res == &b) {
+		res += a;
+		return;
+	}
+	if (&res != &a) {
+		res = a;
+	}
+	res += b;
+}
+
+void sub(big_integer &res, big_integer const &a, big_integer const &b) {
+	if (&res == &b && &res != &a) {
+		// a - b == ~b + 1 + a
+		res.flip_bits();
+		res.add_with_carry(a, false, 1);
+		return;
+	}
+	if (&res != &a) {
+		res = a;
+	}
+	res -= b;
+}
+
+// если множители не лежат в лимбах res, произведение пишется прямо в них, без промежуточного буфера
+void mul(big_integer &res, big_integer const &a, big_integer const &b) {
+	scratch_space::frame frame;
+	size_t n, m;
+	digit_t const *x = a.magnitude(frame, n);
+	digit_t const *y = b.magnitude(frame, m);
+	bool negative = a.inf_1_after_last_digit != b.inf_1_after_last_digit;
+	if (x == res.value.data() || y == res.value.data()) {
+		digit_t *p = frame.alloc(n + m);
+		limb_kernels::mul_basecase(p, x, n, y, m);
+		res.assign_magnitude(p, n + m, negative);
+		return;
+	}
+	res.value.clear();
+	res.value.resize(n + m);
+	limb_kernels::mul_basecase(res.value.data(), x, n, y, m);
+	res.inf_1_after_last_digit = false;
+	if (negative) {
+		res.negate();
+	}
+}
+
+// *this +-= x[0..n) * y[0..m) строками addmul_1 / submul_1 прямо по собственным лимбам;
+// x и y не должны указывать в них
+void big_integer::addmul_limbs(digit_t const *x, size_t n, digit_t const *y, size_t m, bool subtract) {
+	if (n == 0 || m == 0) {
+		return;
+	}
+	// лишний лимб знака: промежуточные суммы монотонны и по модулю не больше итоговой
+	size_t size_ = std::max(size(), n + m) + 1;
+	value.resize(size_, get_inf_digit());
+	digit_t *r = value.data();
+	digit_t overflow = 0;
+	for (size_t j = 0; j < m; ++j) {
+		if (subtract) {
+			digit_t borrow = limb_kernels::submul_1(r + j, x, n, y[j]);
+			overflow |= limb_kernels::sub_1(r + j + n, r + j + n, size_ - j - n, borrow);
+		} else {
+			digit_t carry = limb_kernels::addmul_1(r + j, x, n, y[j]);
+			overflow |= limb_kernels::add_1(r + j + n, r + j + n, size_ - j - n, carry);
+		}
+	}
+	// перенос за старший лимб означает переход через ноль, и он случается не больше одного раза
+	if (overflow != 0) {
+		inf_1_after_last_digit = !inf_1_after_last_digit;
+	}
+}
+
+// acc +-= a * y, где |y| = y[0..m) и y не указывает в лимбы acc
+void big_integer::mul_add(big_integer &acc, big_integer const &a, digit_t const *y, size_t m, bool y_negative,
+                          bool subtract) {
+	scratch_space::frame frame;
+	size_t n;
+	digit_t const *x = a.magnitude(frame, n);
+	if (&a == &acc && !a.inf_1_after_last_digit) {
+		digit_t *copy = frame.alloc(n);
+		std::copy(x, x + n, copy);
+		x = copy;
+	}
+	if (n < m) {
+		std::swap(x, y);
+		std::swap(n, m);
+	}
+	acc.addmul_limbs(x, n, y, m, subtract != (a.inf_1_after_last_digit != y_negative));
+}
+
+void big_integer::mul_add(big_integer &acc, big_integer const &a, big_integer const &b, bool subtract) {
+	scratch_space::frame frame;
+	size_t m;
+	digit_t const *y = b.magnitude(frame, m);
+	if (&b == &acc && !b.inf_1_after_last_digit) {
+		digit_t *copy = frame.alloc(m);
+		std::copy(y, y + m, copy);
+		y = copy;
+	}
+	mul_add(acc, a, y, m, b.inf_1_after_last_digit, subtract);
+}
+
+void addmul(big_integer &acc, big_integer const &a, big_integer const &b) {
+	big_integer::mul_add(acc, a, b, false);
+}
+
+void submul(big_integer &acc, big_integer const &a, big_integer const &b) {
+	big_integer::mul_add(acc, a, b, true);
+}
+
+void addmul(big_integer &acc, big_integer const &a, digit_t b) {
+	big_integer::mul_add(acc, a, &b, 1, false, false);
+}
+
+void submul(big_integer &acc, big_integer const &a, digit_t b) {
+	big_integer::mul_add(acc, a, &b, 1, false, true);
+}
+
+void divmod(big_integer &q, big_integer &r, big_integer const &a, big_integer const &b) {
+	assert(&q != &r);
+	big_integer::divide(&q, &r, a, b);
+}
+
+namespace {
+
+bool exp_bit(digit_t const *e, size_t i) {
+	return (e[i / 32] >> (i % 32)) & 1u;
+}
+
+// размер окна по длине показателя: таблица из 2^(k-1) нечётных степеней окупается
+size_t window_size(size_t bits) {
+	size_t const thresholds[] = {8, 24, 80, 240, 672};
+	size_t k = 1;
+	for (size_t t : thresholds) {
+		if (bits <= t) {
+			break;
+		}
+		k++;
+	}
+	return k;
+}
+
+struct plain_ops {
+	void mul(big_integer &res, big_integer const &a, big_integer const &b) const {
+		::mul(res, a, b);
+	}
+
+	void sqr(big_integer &res, big_integer const &a) const {
+		::mul(res, a, a);
+	}
+};
+
+struct barrett_ops {
+	barrett_reducer const &reducer;
+
+	void mul(big_integer &res, big_integer const &a, big_integer const &b) const {
+		::mul(res, a, b);
+		reducer.reduce(res, res);
+	}
+
+	void sqr(big_integer &res, big_integer const &a) const {
+		mul(res, a, a);
+	}
+};
+
+struct montgomery_ops {
+	montgomery_context const &ctx;
+
+	void mul(big_integer &res, big_integer const &a, big_integer const &b) const {
+		ctx.mul(res, a, b);
+	}
+
+	void sqr(big_integer &res, big_integer const &a) const {
+		ctx.sqr(res, a);
+	}
+};
+
+// res = res * g^e скользящим окном слева направо, e = e[0..en) без ведущих нулей;
+// res на входе -- единица в выбранной арифметике
+template <typename Ops>
+void window_pow(Ops const &ops, big_integer &res, big_integer const &g, digit_t const *e, size_t en) {
+	if (en == 0) {
+		return;
+	}
+	size_t bits = en * 32 - __builtin_clz(e[en - 1]);
+	size_t k = window_size(bits);
+	// table[j] = g^(2j + 1)
+	std::vector<big_integer> table(static_cast<size_t>(1) << (k - 1), big_integer(res.get_allocator()));
+	table[0] = g;
+	if (table.size() > 1) {
+		big_integer g2(res.get_allocator());
+		ops.sqr(g2, g);
+		for (size_t j = 1; j < table.size(); ++j) {
+			ops.mul(table[j], table[j - 1], g2);
+		}
+	}
+	bool started = false;
+	for (size_t i = bits; i > 0;) {
+		if (!exp_bit(e, i - 1)) {
+			if (started) {
+				ops.sqr(res, res);
+			}
+			i--;
+			continue;
+		}
+		// окно [l, i) начинается и заканчивается единицей
+		size_t l = i > k ? i - k : 0;
+		while (!exp_bit(e, l)) {
+			l++;
+		}
+		size_t w = 0;
+		for (size_t j = i; j > l; --j) {
+			w = 2 * w + exp_bit(e, j - 1);
+		}
+		if (started) {
+			for (size_t j = l; j < i; ++j) {
+				ops.sqr(res, res);
+			}
+			ops.mul(res, res, table[w / 2]);
+		} else {
+			res = table[w / 2];
+			started = true;
+		}
+		i = l;
+	}
+}
+
+}
+
+big_integer pow(big_integer const &base, big_integer const &exp) {
+	if (exp.inf_1_after_last_digit) {
+		throw std::runtime_error("negative exponent");
+	}
+	big_integer res(1, result_allocator(base));
+	window_pow(plain_ops(), res, base, exp.value.data(), exp.size());
+	return res;
+}
+
+big_integer powmod(big_integer const &base, big_integer const &exp, big_integer const &mod) {
+	if (exp.inf_1_after_last_digit) {
+		throw std::runtime_error("negative exponent");
+	}
+	big_integer m = mod < 0 ? -mod : mod;
+	if (m == 0) {
+		throw std::runtime_error("division by zero");
+	}
+	big_integer g = base % m;
+	if (g < 0) {
+		g += m;
+	}
+	if (m.value[0] % 2 == 0) {
+		barrett_reducer reducer(m);
+		big_integer res = 1 % m;
+		window_pow(barrett_ops{reducer}, res, g, exp.value.data(), exp.size());
+		return res;
+	}
+	montgomery_context ctx(m);
+	big_integer res = ctx.one();
+	window_pow(montgomery_ops{ctx}, res, ctx.to_montgomery(g), exp.value.data(), exp.size());
+	return ctx.from_montgomery(res);
+}
+
+// Общая часть divexact и divisible. Степень двойки из b сокращается сдвигом (a обязано делиться на неё),
+// нечётный остаток делится по Хенселю. Если q == nullptr, частное не считается, а проверяется делимость
+bool big_integer::divide_exact(big_integer *q, big_integer const &a, big_integer const &b) {
+	scratch_space::frame frame;
+	size_t un, dn;
+	digit_t const *u = a.magnitude(frame, un);
+	digit_t const *d = b.magnitude(frame, dn);
+	if (dn == 0) {
+		throw std::runtime_error("division by zero");
+	}
+	if (un == 0) {
+		if (q != nullptr) {
+			*q = 0;
+		}
+		return true;
+	}
+	size_t zl = 0;
+	while (d[zl] == 0) {
+		zl++;
+	}
+	unsigned zb = __builtin_ctz(d[zl]);
+	for (size_t i = 0; i < std::min(zl, un); ++i) {
+		if (u[i] != 0) {
+			return false;
+		}
+	}
+	if (un <= zl || (u[zl] & ((to64(1) << zb) - 1)) != 0) {
+		return false;
+	}
+	dn -= zl;
+	un -= zl;
+	digit_t *dd = frame.alloc(dn);
+	digit_t *uu = frame.alloc(un);
+	limb_kernels::rshift(dd, d + zl, dn, zb);
+	limb_kernels::rshift(uu, u + zl, un, zb);
+	while (dd[dn - 1] == 0) {
+		dn--;
+	}
+	while (un > 0 && uu[un - 1] == 0) {
+		un--;
+	}
+	if (un < dn) {
+		return false;
+	}
+	if (q == nullptr) {
+		return limb_kernels::divisible_odd(uu, un, dd, dn);
+	}
+	size_t qn = un - dn + 1;
+	digit_t *qs = frame.alloc(qn);
+	limb_kernels::divexact(qs, uu, un, dd, dn);
+	q->assign_magnitude(qs, qn, a.inf_1_after_last_digit != b.inf_1_after_last_digit);
+	return true;
+}
+
+big_integer divexact(big_integer const &a, big_integer const &b) {
+	big_integer q(result_allocator(a));
+	big_integer::divide_exact(&q, a, b);
+	return q;
+}
+
+bool divisible(big_integer const &a, big_integer const &b) {
+	if (b == 0) {
+		return a == 0;
+	}
+	return big_integer::divide_exact(nullptr, a, b);
+}
+
+// младшие k бит a и -a нулевые одновременно, так что смотрим прямо на дополнительный код
+bool divisible_2exp(big_integer const &a, size_t k) {
+	size_t limbs = k / 32;
+	for (size_t i = 0; i < std::min(limbs, a.size()); ++i) {
+		if (a.value[i] != 0) {
+			return false;
+		}
+	}
+	if (limbs > a.size()) {
+		// все лимбы нулевые, дальше идёт бесконечный хвост
+		return !a.inf_1_after_last_digit;
+	}
+	return (a.get(limbs) & ((to64(1) << (k % 32)) - 1)) == 0;
+}
+
+// (*this >> shift) mod 2^64 для неотрицательного числа
+uint64_t big_integer::leading_bits(size_t shift) const {
+	size_t i = shift / 32;
+	unsigned r = shift % 32;
+	uint128_t w = to128(get(i)) | (to128(get(i + 1)) << 32u) | (to128(get(i + 2)) << 64u);
+	return static_cast<uint64_t>(w >> r);
+}
+
+namespace {
+
+uint64_t binary_gcd(uint64_t a, uint64_t b) {
+	if (a == 0 || b == 0) {
+		return a | b;
+	}
+	unsigned k = __builtin_ctzll(a | b);
+	a >>= __builtin_ctzll(a);
+	while (b != 0) {
+		b >>= __builtin_ctzll(b);
+		if (a > b) {
+			std::swap(a, b);
+		}
+		b -= a;
+	}
+	return a << k;
+}
+
+// res = x * p + y * q; tmp -- буфер, чтобы не выделять память на каждом шаге
+void combine(big_integer &res, big_integer const &x, int64_t p, big_integer const &y, int64_t q, big_integer &tmp) {
+	res = x;
+	res *= p;
+	tmp = y;
+	tmp *= q;
+	res += tmp;
+}
+
+}
+
+// Алгоритм Лемера (Кнут, 4.5.2, алгоритм L) над x >= y >= 0: частные угадываются по 62 старшим битам,
+// пока это возможно, и применяются к длинным числам одной матрицей [[A, B], [C, D]].
+// Если угадать не удалось ни одного частного, делается обычный шаг Евклида.
+// Заканчивает, когда y == 0 или оба числа помещаются в 64 бита. sx и sy, если заданы,
+// преобразуются той же матрицей (для gcdext)
+void big_integer::euclid(big_integer &x, big_integer &y, big_integer *sx, big_integer *sy) {
+	big_integer nx(x.get_allocator()), ny(x.get_allocator()), tmp(x.get_allocator());
+	while (y != 0 && x.size() > 2) {
+		size_t shift = x.bit_length() - 62;
+		int64_t xh = static_cast<int64_t>(x.leading_bits(shift));
+		int64_t yh = static_cast<int64_t>(y.leading_bits(shift));
+		int64_t A = 1, B = 0, C = 0, D = 1;
+		while (yh + C > 0 && yh + D > 0) {
+			int64_t q = (xh + A) / (yh + C);
+			if (q != (xh + B) / (yh + D)) {
+				break;
+			}
+			int64_t t = A - q * C;
+			A = C;
+			C = t;
+			t = B - q * D;
+			B = D;
+			D = t;
+			t = xh - q * yh;
+			xh = yh;
+			yh = t;
+		}
+		if (B == 0) {
+			divmod(nx, ny, x, y);
+			if (sx != nullptr) {
+				// (sx, sy) = (sy, sx - q * sy)
+				submul(*sx, nx, *sy);
+				std::swap(*sx, *sy);
+			}
+			std::swap(x, y);
+			std::swap(y, ny);
+			continue;
+		}
+		combine(nx, x, A, y, B, tmp);
+		combine(ny, x, C, y, D, tmp);
+		std::swap(x, nx);
+		std::swap(y, ny);
+		if (sx != nullptr) {
+			combine(nx, *sx, A, *sy, B, tmp);
+			combine(ny, *sx, C, *sy, D, tmp);
+			std::swap(*sx, nx);
+			std::swap(*sy, ny);
+		}
+	}
+}
+
+big_integer gcd(big_integer const &a, big_integer const &b) {
+	big_integer x = a < 0 ? -a : a;
+	big_integer y = b < 0 ? -b : b;
+	if (x < y) {
+		std::swap(x, y);
+	}
+	big_integer::euclid(x, y, nullptr, nullptr);
+	if (y == 0) {
+		return x;
+	}
+	return big_integer(binary_gcd(x.leading_bits(0), y.leading_bits(0)), result_allocator(a));
+}
+
+// Каждое промежуточное v из пары (x, y) помнит s_v, для которого v == s_v * |a| (mod |b|);
+// в конце t = (g - s * |a|) / |b| делится нацело
+void gcdext(big_integer &g, big_integer &s, big_integer &t, big_integer const &a, big_integer const &b) {
+	assert(&g != &s && &g != &t && &s != &t);
+	big_integer abs_a = a < 0 ? -a : a;
+	big_integer abs_b = b < 0 ? -b : b;
+	if (abs_b == 0) {
+		g = abs_a;
+		s = a < 0 ? -1 : (a == 0 ? 0 : 1);
+		t = 0;
+		return;
+	}
+	big_integer x = abs_a, y = abs_b, sx = 1, sy = 0;
+	if (x < y) {
+		std::swap(x, y);
+		std::swap(sx, sy);
+	}
+	big_integer::euclid(x, y, &sx, &sy);
+	// хвост, где оба числа короткие, -- обычный Евклид
+	big_integer q, r;
+	while (y != 0) {
+		divmod(q, r, x, y);
+		submul(sx, q, sy);
+		std::swap(sx, sy);
+		std::swap(x, y);
+		std::swap(y, r);
+	}
+	g = x;
+	s = sx;
+	t = g;
+	submul(t, s, abs_a);
+	t = divexact(t, abs_b);
+	if (a < 0) {
+		s.negate();
+	}
+	if (b < 0) {
+		t.negate();
+	}
+}
+
+big_integer invert(big_integer const &a, big_integer const &m) {
+	big_integer g, s, t;
+	gcdext(g, s, t, a, m);
+	if (g != 1) {
+		throw std::runtime_error("not invertible");
+	}
+	big_integer abs_m = m < 0 ? -m : m;
+	s %= abs_m;
+	if (s < 0) {
+		s += abs_m;
+	}
+	return s;
+}
+
+// floor(a^(1/k)) для a >= 0, k >= 2. Корень из a >> (k * m), где m -- примерно половина бит корня,
+// сдвинутый обратно и увеличенный на единицу, не меньше ответа; с такого приближения
+// x = ((k - 1) * x + a / x^(k - 1)) / k монотонно убывает до ответа
+big_integer big_integer::root(big_integer const &a, unsigned k) {
+	size_t bits = a.bit_length();
+	if (bits <= k) {
+		return a == 0 ? 0 : 1;
+	}
+	if (k == 2 && bits <= 64) {
+		uint64_t v = a.leading_bits(0);
+		auto r = static_cast<uint64_t>(std::sqrt(static_cast<long double>(v)));
+		while (to128(r) * r > v) {
+			r--;
+		}
+		while (to128(r + 1) * (r + 1) <= v) {
+			r++;
+		}
+		return big_integer(r, result_allocator(a));
+	}
+	size_t m = bits / (2 * k);
+	big_integer x(result_allocator(a));
+	if (m == 0) {
+		x = 1;
+		x <<= static_cast<int>((bits + k - 1) / k);
+	} else {
+		x = root(a >> static_cast<int>(k * m), k);
+		++x;
+		x <<= static_cast<int>(m);
+	}
+	big_integer y(x.get_allocator()), p(x.get_allocator());
+	big_integer const k_1(k - 1);
+	while (true) {
+		p = k == 2 ? x : pow(x, k_1);
+		y = a / p;
+		addmul(y, x, static_cast<digit_t>(k - 1));
+		y /= k;
+		if (y >= x) {
+			return x;
+		}
+		std::swap(x, y);
+	}
+}
+
+big_integer isqrt(big_integer const &a) {
+	if (a < 0) {
+		throw std::runtime_error("square root of negative number");
+	}
+	return big_integer::root(a, 2);
+}
+
+void isqrt_rem(big_integer &s, big_integer &r, big_integer const &a) {
+	assert(&s != &r);
+	big_integer root = isqrt(a);
+	r = a;
+	submul(r, root, root);
+	s = std::move(root);
+}
+
+big_integer iroot(big_integer const &a, unsigned k) {
+	if (k == 0) {
+		throw std::runtime_error("zeroth root");
+	}
+	if (k == 1) {
+		return a;
+	}
+	if (a < 0) {
+		if (k % 2 == 0) {
+			throw std::runtime_error("even root of negative number");
+		}
+		return -big_integer::root(-a, k);
+	}
+	return big_integer::root(a, k);
+}
+
+void divmod(big_integer &q, big_integer &r, big_integer const &a, divisor const &d) {
+	assert(&q != &r);
+	big_integer::divide(&q, &r, a, d, false);
+}
+
 bool operator==(big_integer const &a, big_integer const &b) {
 	return a.compare_to(b) == 0;
 }
@@ -480,16 +1620,29 @@ bool operator>=(big_integer const &a, big_integer const &b) {
 }
 
 std::string to_string(big_integer const &a) {
+	scratch_space::frame frame;
+	size_t n;
+	digit_t const *mag = a.magnitude(frame, n);
+	digit_t *u = frame.alloc(n);
+	std::copy(mag, mag + n, u);
 	std::string res;
-	big_integer tmp(a < 0 ? -a : a);
-	while (tmp >= 0) {
-		res += std::to_string((tmp % 10).value[0]);
-		tmp /= 10;
-		if (tmp == 0) {
-			break;
+	res.reserve(n * 10 + 2);
+	// по 9 десятичных цифр за одно деление, цифры получаются от младших к старшим
+	static divisor const billion(1000000000);
+	while (n > 0) {
+		digit_t chunk = to32(billion.divrem(u, u, n));
+		while (n > 0 && u[n - 1] == 0) {
+			n--;
+		}
+		for (size_t i = 0; i < 9 && (n > 0 || chunk > 0); ++i) {
+			res += static_cast<char>('0' + chunk % 10);
+			chunk /= 10;
 		}
 	}
-	if (a < 0) {
+	if (res.empty()) {
+		res += '0';
+	}
+	if (a.inf_1_after_last_digit) {
 		res += '-';
 	}
 	std::reverse(res.begin(), res.end());
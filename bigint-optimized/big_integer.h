@@ -3,11 +3,22 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <memory_resource>
 #include <string>
+#include <type_traits>
 #include <vector>
 
+#include "divisor.h"
+#include "limb_pool.h"
+#include "scratch_space.h"
+
 typedef unsigned __int128 uint128_t;
 
+// встроенные целые не шире 64 бит: для них есть операторы без временного big_integer
+template <typename T>
+using big_integer_native_t = std::enable_if_t<
+	std::is_integral<T>::value && !std::is_same<T, bool>::value && sizeof(T) <= sizeof(uint64_t)>;
+
 struct big_integer
 {
 	using digit_t = uint32_t;
@@ -15,69 +26,331 @@ struct big_integer
 	static const digit_t MAX_DIGIT = UINT32_MAX;
 	static const uint64_t BASE = static_cast<uint64_t>(MAX_DIGIT) + 1;
 	static const uint128_t BASE128 = static_cast<uint128_t>(BASE);
+	using allocator_type = std::pmr::polymorphic_allocator<digit_t>;
+	using storage_t = std::vector<digit_t, allocator_type>;
 
 	big_integer();
+	explicit big_integer(allocator_type const &alloc);
 	big_integer(big_integer const &other);
-	big_integer(int a);
-	big_integer(digit_t a);
-	big_integer(uint64_t a);
-	big_integer(uint128_t a);
-	explicit big_integer(std::string const &str);
+	big_integer(big_integer const &other, allocator_type const &alloc);
+	big_integer(big_integer &&other) noexcept;
+	big_integer(int a, allocator_type const &alloc = default_allocator());
+	big_integer(digit_t a, allocator_type const &alloc = default_allocator());
+	big_integer(uint64_t a, allocator_type const &alloc = default_allocator());
+	big_integer(uint128_t a, allocator_type const &alloc = default_allocator());
+	explicit big_integer(std::string const &str, allocator_type const &alloc = default_allocator());
 	~big_integer();
 
+	// копии и результаты операций живут в памяти левого операнда, если её задал пользователь;
+	// иначе -- в default_allocator(): внутри limb_arena::scope это арена, вне его limb_pool
+	allocator_type get_allocator() const;
+	static allocator_type default_allocator();
+
 	big_integer &operator=(big_integer const &rhs);
+	big_integer &operator=(big_integer &&rhs);
+	// выражения из big_integer_expr.h вычисляются сразу в *this; определены там же
+	template <typename Expr, typename = decltype(&Expr::assign_to)>
+	big_integer &operator=(Expr const &e);
+	template <typename Expr, typename = decltype(&Expr::add_to)>
+	big_integer &operator+=(Expr const &e);
+	template <typename Expr, typename = decltype(&Expr::sub_from)>
+	big_integer &operator-=(Expr const &e);
 	big_integer &operator+=(big_integer const &rhs);
 	big_integer &operator-=(big_integer const &rhs);
+	// naive_mul, div_by_short, div128 и limb_div, как и раньше, меняют *this и возвращают копию результата
 	big_integer naive_mul(big_integer const &rhs);
 	big_integer &operator*=(big_integer const &rhs);
 	big_integer div_by_short(digit_t d);
 	big_integer div128(big_integer const &rhs);
 	big_integer limb_div(big_integer const &rhs);
+	big_integer &limb_mod(big_integer const &rhs);
 	big_integer &operator/=(big_integer const &rhs);
+	big_integer &operator/=(divisor const &rhs);
 
 	big_integer &operator%=(big_integer const &rhs);
+	big_integer &operator%=(divisor const &rhs);
 	big_integer &operator&=(big_integer const &rhs);
 	big_integer &operator|=(big_integer const &rhs);
 	big_integer &operator^=(big_integer const &rhs);
 	big_integer &operator<<=(int rhs);
 	big_integer &operator>>=(int rhs);
+	// присваивание встроенного целого пишет в собственный буфер, а не меняет его на буфер временного объекта
+	template <typename T, typename = big_integer_native_t<T>>
+	big_integer &operator=(T rhs);
+	// остаток, как и у big_integer, берёт знак делимого
+	template <typename T, typename = big_integer_native_t<T>>
+	big_integer &operator+=(T rhs);
+	template <typename T, typename = big_integer_native_t<T>>
+	big_integer &operator-=(T rhs);
+	template <typename T, typename = big_integer_native_t<T>>
+	big_integer &operator*=(T rhs);
+	template <typename T, typename = big_integer_native_t<T>>
+	big_integer &operator/=(T rhs);
+	template <typename T, typename = big_integer_native_t<T>>
+	big_integer &operator%=(T rhs);
 
 	big_integer operator+() const;
-	big_integer operator-() const;
-	big_integer operator~() const;
+	big_integer operator-() const &;
+	big_integer operator-() &&;
+	big_integer operator~() const &;
+	big_integer operator~() &&;
 	big_integer &operator++();
 	big_integer operator++(int);
 	big_integer &operator--();
 	big_integer operator--(int);
+	// *this = -*this на месте за один проход
+	void negate();
 
+	// число значащих лимбов, без лишних знаковых сверху
 	size_t size() const;
+	// Память под лимбы операции не отдают: результат, который стал короче, остаётся в прежнем буфере,
+	// и следующее удлинение обходится без выделения. Вернуть лишнее можно только явно
+	size_t capacity() const;
+	void reserve(size_t limbs);
+	// приводит число к каноническому виду и отдаёт лишнюю память
+	void shrink_to_fit();
 	int compare_to(big_integer const &other) const;
+	template <typename T, typename = big_integer_native_t<T>>
+	int compare_to(T other) const;
+
+	// Биты в дополнительном коде: у отрицательного числа выше лимбов идёт бесконечная цепочка единиц.
+	// Все операции затрагивают только нужные лимбы, а не всё число.
+	// bit_length -- число бит без знаковой цепочки (для a < 0 -- как у ~a);
+	// popcount -- число единиц, а для a < 0 -- число нулей (единиц бесконечно много);
+	// countr_zero -- номер младшей единицы, для нуля SIZE_MAX
+	size_t bit_length() const;
+	size_t popcount() const;
+	size_t countr_zero() const;
+	bool test_bit(size_t k) const;
+	void set_bit(size_t k);
+	void clear_bit(size_t k);
+	void flip_bit(size_t k);
+	// сбрасывает все биты, установленные в mask: *this &= ~mask без временного ~mask
+	void clear_bits(big_integer const &mask);
+	// биты [pos, pos + len) как неотрицательное число
+	big_integer extract_bits(size_t pos, size_t len) const;
 
 	friend std::string to_string(big_integer const &bi);
+	friend void add(big_integer &res, big_integer const &a, big_integer const &b);
+	friend void sub(big_integer &res, big_integer const &a, big_integer const &b);
+	friend void mul(big_integer &res, big_integer const &a, big_integer const &b);
+	friend void shl(big_integer &res, big_integer const &a, size_t k);
+	friend void shr(big_integer &res, big_integer const &a, size_t k);
+	friend void divmod(big_integer &q, big_integer &r, big_integer const &a, big_integer const &b);
+	friend void divmod(big_integer &q, big_integer &r, big_integer const &a, divisor const &d);
+	friend void addmul(big_integer &acc, big_integer const &a, big_integer const &b);
+	friend void submul(big_integer &acc, big_integer const &a, big_integer const &b);
+	friend void addmul(big_integer &acc, big_integer const &a, digit_t b);
+	friend void submul(big_integer &acc, big_integer const &a, digit_t b);
+	friend struct montgomery_context;
+	friend struct barrett_reducer;
+	friend struct compact_integer;
+	friend big_integer pow(big_integer const &base, big_integer const &exp);
+	friend big_integer powmod(big_integer const &base, big_integer const &exp, big_integer const &mod);
+	friend big_integer divexact(big_integer const &a, big_integer const &b);
+	friend bool divisible(big_integer const &a, big_integer const &b);
+	friend bool divisible_2exp(big_integer const &a, size_t k);
+	friend big_integer gcd(big_integer const &a, big_integer const &b);
+	friend void gcdext(big_integer &g, big_integer &s, big_integer &t, big_integer const &a, big_integer const &b);
+	friend big_integer isqrt(big_integer const &a);
+	friend big_integer iroot(big_integer const &a, unsigned k);
 
 private:
-	std::vector<digit_t> value;
+	// Нормализация ленивая: сверху value могут лежать лишние лимбы, равные get_inf_digit(). Число от них
+	// не меняется, поэтому операции работают с ними как с обычными, а длину результата считают от size(),
+	// так что лишних лимбов не больше, чем добавила одна операция. Канонический вид нужен только
+	// модулям montgomery_context и barrett_reducer; normalize() отрезает лишние лимбы явно
+	storage_t value;
 	bool inf_1_after_last_digit;  // a.inf_1_after_last_digit == true <=> a < 0;
 
 	digit_t get(size_t i) const;
 	digit_t get_inf_digit() const;
-	void shrink_to_fit();
-	void block_shl(size_t cnt);
-	void block_shr(size_t cnt);
+	void normalize();
+	digit_t const *magnitude(scratch_space::frame &frame, size_t &n) const;
+	void assign_magnitude(digit_t const *mag, size_t n, bool negative);
+	void add_limbs(digit_t const *b, size_t bn, bool b_inf, bool invert, uint32_t carry_in);
+	void add_with_carry(big_integer const &b, bool invert, uint32_t carry_in);
+	void addmul_limbs(digit_t const *x, size_t n, digit_t const *y, size_t m, bool subtract);
+	static void mul_add(big_integer &acc, big_integer const &a, digit_t const *y, size_t m, bool y_negative,
+	                    bool subtract);
+	static void mul_add(big_integer &acc, big_integer const &a, big_integer const &b, bool subtract);
+	void flip_bits();
+	// встроенное целое x передаётся как bits = x mod 2^64 и negative = x < 0
+	template <typename T>
+	static uint64_t native_bits(T x);
+	template <typename T>
+	static bool native_negative(T x);
+	void ripple(size_t from, digit_t c, bool borrow);
+	void add_native(uint64_t bits, bool negative);
+	void mul_native(uint64_t bits, bool negative);
+	void divide_native(uint64_t bits, bool negative, bool remainder);
+	static void divide(big_integer *q, big_integer *r, big_integer const &a, divisor const &d, bool d_negative);
+	int compare_native(uint64_t bits, bool negative) const;
+	static void divide(big_integer *q, big_integer *r, big_integer const &a, big_integer const &b);
+	static void divide(big_integer *q, big_integer *r, big_integer const &a, digit_t const *d, size_t dn,
+	                   bool d_negative);
+	static bool divide_exact(big_integer *q, big_integer const &a, big_integer const &b);
+	uint64_t leading_bits(size_t shift) const;
+	digit_t &limb_with_bit(size_t k);
+	static void euclid(big_integer &x, big_integer &y, big_integer *sx, big_integer *sy);
+	static big_integer root(big_integer const &a, unsigned k);
 };
 
+template <typename T>
+uint64_t big_integer::native_bits(T x) {
+	return static_cast<uint64_t>(x);
+}
+
+template <typename T>
+bool big_integer::native_negative(T x) {
+	return std::is_signed<T>::value && x < 0;
+}
+
+template <typename T, typename>
+big_integer &big_integer::operator=(T rhs) {
+	value.clear();
+	inf_1_after_last_digit = false;
+	add_native(native_bits(rhs), native_negative(rhs));
+	return *this;
+}
+
+template <typename T, typename>
+big_integer &big_integer::operator+=(T rhs) {
+	add_native(native_bits(rhs), native_negative(rhs));
+	return *this;
+}
 
+// a - x == a + (-x); -x по модулю 2^64 не переполняется и для INT64_MIN
+template <typename T, typename>
+big_integer &big_integer::operator-=(T rhs) {
+	uint64_t bits = native_bits(rhs);
+	add_native(0 - bits, bits != 0 && !native_negative(rhs));
+	return *this;
+}
+
+template <typename T, typename>
+big_integer &big_integer::operator*=(T rhs) {
+	mul_native(native_bits(rhs), native_negative(rhs));
+	return *this;
+}
+
+template <typename T, typename>
+big_integer &big_integer::operator/=(T rhs) {
+	divide_native(native_bits(rhs), native_negative(rhs), false);
+	return *this;
+}
+
+template <typename T, typename>
+big_integer &big_integer::operator%=(T rhs) {
+	divide_native(native_bits(rhs), native_negative(rhs), true);
+	return *this;
+}
+
+template <typename T, typename>
+int big_integer::compare_to(T other) const {
+	return compare_native(native_bits(other), native_negative(other));
+}
+
+
+#ifndef BIG_INTEGER_EXPRESSION_TEMPLATES
+// с подключённым big_integer_expr.h вместо этих операторов работают шаблоны выражений
 big_integer operator+(big_integer a, big_integer const &b);
 big_integer operator-(big_integer a, big_integer const &b);
 big_integer operator*(big_integer a, big_integer const &b);
+big_integer operator%(big_integer a, big_integer const &b);
+// временный правый операнд отдаёт свой буфер под результат
+big_integer operator+(big_integer const &a, big_integer &&b);
+big_integer operator+(big_integer &&a, big_integer &&b);
+big_integer operator-(big_integer const &a, big_integer &&b);
+big_integer operator-(big_integer &&a, big_integer &&b);
+big_integer operator*(big_integer const &a, big_integer &&b);
+big_integer operator*(big_integer &&a, big_integer &&b);
+
+template <typename T, typename = big_integer_native_t<T>>
+big_integer operator+(big_integer a, T b) {
+	return a += b;
+}
+
+template <typename T, typename = big_integer_native_t<T>>
+big_integer operator-(big_integer a, T b) {
+	return a -= b;
+}
+
+template <typename T, typename = big_integer_native_t<T>>
+big_integer operator*(big_integer a, T b) {
+	return a *= b;
+}
+
+template <typename T, typename = big_integer_native_t<T>>
+big_integer operator%(big_integer a, T b) {
+	return a %= b;
+}
+#endif
+
+template <typename T, typename = big_integer_native_t<T>>
+big_integer operator/(big_integer a, T b) {
+	return a /= b;
+}
+
 big_integer operator&(big_integer a, big_integer const &b);
 big_integer operator|(big_integer a, big_integer const &b);
 big_integer operator^(big_integer a, big_integer const &b);
+big_integer operator&(big_integer const &a, big_integer &&b);
+big_integer operator&(big_integer &&a, big_integer &&b);
+big_integer operator|(big_integer const &a, big_integer &&b);
+big_integer operator|(big_integer &&a, big_integer &&b);
+big_integer operator^(big_integer const &a, big_integer &&b);
+big_integer operator^(big_integer &&a, big_integer &&b);
 big_integer operator/(big_integer a, big_integer const &b);
-big_integer operator%(big_integer a, big_integer const &b);
+big_integer operator/(big_integer a, divisor const &b);
+big_integer operator%(big_integer a, divisor const &b);
 big_integer operator<<(big_integer, int);
 big_integer operator>>(big_integer, int);
 
+// результат пишется в уже существующий объект с переиспользованием его памяти;
+// res может совпадать с любым из аргументов
+void add(big_integer &res, big_integer const &a, big_integer const &b);
+void sub(big_integer &res, big_integer const &a, big_integer const &b);
+void mul(big_integer &res, big_integer const &a, big_integer const &b);
+// res = a * 2^k и res = floor(a / 2^k) за один проход по лимбам a
+void shl(big_integer &res, big_integer const &a, size_t k);
+void shr(big_integer &res, big_integer const &a, size_t k);
+// деление с округлением к нулю; q и r -- разные объекты, но могут совпадать с a или b
+void divmod(big_integer &q, big_integer &r, big_integer const &a, big_integer const &b);
+void divmod(big_integer &q, big_integer &r, big_integer const &a, divisor const &d);
+// acc += a * b и acc -= a * b без построения произведения: строки a * b[j] сразу прибавляются к лимбам acc;
+// acc может совпадать с a или b
+void addmul(big_integer &acc, big_integer const &a, big_integer const &b);
+void submul(big_integer &acc, big_integer const &a, big_integer const &b);
+void addmul(big_integer &acc, big_integer const &a, big_integer::digit_t b);
+void submul(big_integer &acc, big_integer const &a, big_integer::digit_t b);
+// base^exp и base^exp mod |mod| (результат в [0, |mod|)) скользящим окном; exp >= 0.
+// Для нечётного модуля умножения идут в форме Монтгомери, для чётного -- с редукцией Барретта
+big_integer pow(big_integer const &base, big_integer const &exp);
+big_integer powmod(big_integer const &base, big_integer const &exp, big_integer const &mod);
+// a / b, когда заранее известно, что b делит a (иначе результат не определён): деление по Хенселю
+// от младших лимбов без оценки частного
+big_integer divexact(big_integer const &a, big_integer const &b);
+// b | a без вычисления частного; на ноль делится только ноль
+bool divisible(big_integer const &a, big_integer const &b);
+// 2^k | a
+bool divisible_2exp(big_integer const &a, size_t k);
+// НОД (неотрицательный; gcd(0, 0) == 0): алгоритм Лемера по двум старшим лимбам, пока числа длинные,
+// и бинарный алгоритм, когда оба помещаются в 64 бита
+big_integer gcd(big_integer const &a, big_integer const &b);
+// g = gcd(a, b) = a * s + b * t; g, s и t -- разные объекты
+void gcdext(big_integer &g, big_integer &s, big_integer &t, big_integer const &a, big_integer const &b);
+// x из [0, |m|) с a * x == 1 (mod m); если gcd(a, m) != 1, бросает std::runtime_error
+big_integer invert(big_integer const &a, big_integer const &m);
+// floor(sqrt(a)) и floor(a^(1/k)) итерацией Ньютона с удвоением точности: приближение к корню
+// из старшей половины бит уточняется одним-двумя шагами, так что основная работа -- пара делений
+// полного размера. Для отрицательного a и нечётного k корень округляется к нулю;
+// isqrt и iroot с чётным k от отрицательного числа бросают std::runtime_error
+big_integer isqrt(big_integer const &a);
+// s = isqrt(a), r = a - s * s; s и r -- разные объекты
+void isqrt_rem(big_integer &s, big_integer &r, big_integer const &a);
+big_integer iroot(big_integer const &a, unsigned k);
+
 bool operator==(big_integer const &a, big_integer const &b);
 bool operator!=(big_integer const &a, big_integer const &b);
 bool operator<(big_integer const &a, big_integer const &b);
@@ -85,6 +358,67 @@ bool operator>(big_integer const &a, big_integer const &b);
 bool operator<=(big_integer const &a, big_integer const &b);
 bool operator>=(big_integer const &a, big_integer const &b);
 
+// сравнения со встроенными целыми смотрят не больше двух младших лимбов
+template <typename T, typename = big_integer_native_t<T>>
+bool operator==(big_integer const &a, T b) {
+	return a.compare_to(b) == 0;
+}
+
+template <typename T, typename = big_integer_native_t<T>>
+bool operator!=(big_integer const &a, T b) {
+	return a.compare_to(b) != 0;
+}
+
+template <typename T, typename = big_integer_native_t<T>>
+bool operator<(big_integer const &a, T b) {
+	return a.compare_to(b) < 0;
+}
+
+template <typename T, typename = big_integer_native_t<T>>
+bool operator>(big_integer const &a, T b) {
+	return a.compare_to(b) > 0;
+}
+
+template <typename T, typename = big_integer_native_t<T>>
+bool operator<=(big_integer const &a, T b) {
+	return a.compare_to(b) <= 0;
+}
+
+template <typename T, typename = big_integer_native_t<T>>
+bool operator>=(big_integer const &a, T b) {
+	return a.compare_to(b) >= 0;
+}
+
+template <typename T, typename = big_integer_native_t<T>>
+bool operator==(T a, big_integer const &b) {
+	return b.compare_to(a) == 0;
+}
+
+template <typename T, typename = big_integer_native_t<T>>
+bool operator!=(T a, big_integer const &b) {
+	return b.compare_to(a) != 0;
+}
+
+template <typename T, typename = big_integer_native_t<T>>
+bool operator<(T a, big_integer const &b) {
+	return b.compare_to(a) > 0;
+}
+
+template <typename T, typename = big_integer_native_t<T>>
+bool operator>(T a, big_integer const &b) {
+	return b.compare_to(a) < 0;
+}
+
+template <typename T, typename = big_integer_native_t<T>>
+bool operator<=(T a, big_integer const &b) {
+	return b.compare_to(a) >= 0;
+}
+
+template <typename T, typename = big_integer_native_t<T>>
+bool operator>=(T a, big_integer const &b) {
+	return b.compare_to(a) <= 0;
+}
+
 std::string to_string(big_integer const &a);
 std::ostream &operator<<(std::ostream &s, big_integer const &a);
 
@@ -0,0 +1,58 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+
+#include "big_integer.h"
+#include "big_integer_gmp.h"
+
+// Возведение в степень по модулю на размерах RSA-4096: big_integer против mpz_powm.
+// Модуль нечётный (путь Монтгомери), основание и показатель -- полные 4096 бит.
+
+namespace {
+big_integer random_bits(size_t bits, std::mt19937_64& rng) {
+  big_integer res;
+  for (size_t i = 0; i < bits; i += 64) {
+    res <<= 64;
+    res += rng();
+  }
+  return res;
+}
+
+template <typename F>
+double best_ms(int runs, F&& f) {
+  double best = 0;
+  for (int i = 0; i != runs; ++i) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    if (i == 0 || elapsed.count() < best) {
+      best = elapsed.count();
+    }
+  }
+  return best;
+}
+}
+
+int main(int argc, char** argv) {
+  int runs = argc > 1 ? std::stoi(argv[1]) : 10;
+  size_t const bits = 4096;
+  std::mt19937_64 rng(37);
+  big_integer top = big_integer(1) << static_cast<int>(bits - 1);
+  big_integer m = random_bits(bits - 1, rng) | top | 1;
+  big_integer b = random_bits(bits - 1, rng) % m;
+  big_integer e = random_bits(bits - 1, rng) | top;
+  big_integer_gmp gm(to_string(m)), gb(to_string(b)), ge(to_string(e));
+
+  big_integer r;
+  big_integer_gmp gr;
+  double ours = best_ms(runs, [&] { r = powmod(b, e, m); });
+  double gmp = best_ms(runs, [&] { gr = powmod(gb, ge, gm); });
+  if (to_string(r) != to_string(gr)) {
+    std::printf("powmod mismatch\n");
+    return 1;
+  }
+  std::printf("powmod %zu bits: big_integer %.2f ms, gmp %.2f ms, ratio %.2f\n", bits, ours, gmp, ours / gmp);
+  return 0;
+}
@@ -0,0 +1,434 @@
+#ifndef BIG_INTEGER_EXPR_H
+#define BIG_INTEGER_EXPR_H
+
+// Шаблоны выражений над big_integer. Подключение этого заголовка заменяет бинарные +, -, * и %
+// ленивыми узлами, которые вычисляются прямо в приёмник: r = a * b + c, r = a * b - c * d,
+// r = (a + b) % m не создают промежуточных big_integer, произведения в суммах и разностях
+// прибавляются к приёмнику слитной операцией acc +-= x * y.
+// Заголовок должен идти раньше big_integer.h; выражения нельзя сохранять в auto --
+// они ссылаются на операнды, живущие до конца полного выражения.
+
+#if defined(BIG_INTEGER_H) && !defined(BIG_INTEGER_EXPRESSION_TEMPLATES)
+#error "big_integer_expr.h must be included before big_integer.h"
+#endif
+
+#define BIG_INTEGER_EXPRESSION_TEMPLATES
+
+#include "big_integer.h"
+
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+// Каждый узел умеет:
+//   assign_to(dst) -- dst = значение, add_to(dst) -- dst += значение, sub_from(dst) -- dst -= значение;
+//   eval(tmp) -- ссылка на готовый big_integer (сам операнд или tmp, куда посчитано значение);
+//   refers_to(p) -- участвует ли *p в выражении (тогда в p нельзя считать напрямую).
+// Во всех трёх операциях dst не участвует в выражении.
+template <typename E>
+struct expr_base {
+	operator big_integer() const {
+		E const &self = static_cast<E const &>(*this);
+		big_integer res(self.get_allocator());
+		self.assign_to(res);
+		return res;
+	}
+};
+
+struct expr_terminal : expr_base<expr_terminal> {
+	big_integer const &x;
+
+	explicit expr_terminal(big_integer const &x)
+		: x(x) {}
+
+	big_integer::allocator_type get_allocator() const {
+		return x.get_allocator();
+	}
+
+	bool refers_to(big_integer const *p) const {
+		return &x == p;
+	}
+
+	big_integer const &eval(big_integer &) const {
+		return x;
+	}
+
+	void assign_to(big_integer &dst) const {
+		dst = x;
+	}
+
+	void add_to(big_integer &dst) const {
+		dst += x;
+	}
+
+	void sub_from(big_integer &dst) const {
+		dst -= x;
+	}
+};
+
+template <typename T, typename = big_integer_native_t<T>>
+struct expr_scalar : expr_base<expr_scalar<T>> {
+	T x;
+
+	explicit expr_scalar(T x)
+		: x(x) {}
+
+	big_integer::allocator_type get_allocator() const {
+		return big_integer::default_allocator();
+	}
+
+	bool refers_to(big_integer const *) const {
+		return false;
+	}
+
+	big_integer const &eval(big_integer &tmp) const {
+		tmp = x;
+		return tmp;
+	}
+
+	void assign_to(big_integer &dst) const {
+		dst = x;
+	}
+
+	void add_to(big_integer &dst) const {
+		dst += x;
+	}
+
+	void sub_from(big_integer &dst) const {
+		dst -= x;
+	}
+};
+
+template <typename E>
+struct expr_node : expr_base<E> {
+	big_integer const &eval(big_integer &tmp) const {
+		static_cast<E const &>(*this).assign_to(tmp);
+		return tmp;
+	}
+};
+
+template <typename L, typename R>
+struct expr_sum : expr_node<expr_sum<L, R>> {
+	L l;
+	R r;
+
+	expr_sum(L l, R r)
+		: l(l), r(r) {}
+
+	big_integer::allocator_type get_allocator() const {
+		return l.get_allocator();
+	}
+
+	bool refers_to(big_integer const *p) const {
+		return l.refers_to(p) || r.refers_to(p);
+	}
+
+	void assign_to(big_integer &dst) const {
+		l.assign_to(dst);
+		r.add_to(dst);
+	}
+
+	void add_to(big_integer &dst) const {
+		l.add_to(dst);
+		r.add_to(dst);
+	}
+
+	void sub_from(big_integer &dst) const {
+		l.sub_from(dst);
+		r.sub_from(dst);
+	}
+};
+
+template <typename L, typename R>
+struct expr_diff : expr_node<expr_diff<L, R>> {
+	L l;
+	R r;
+
+	expr_diff(L l, R r)
+		: l(l), r(r) {}
+
+	big_integer::allocator_type get_allocator() const {
+		return l.get_allocator();
+	}
+
+	bool refers_to(big_integer const *p) const {
+		return l.refers_to(p) || r.refers_to(p);
+	}
+
+	void assign_to(big_integer &dst) const {
+		l.assign_to(dst);
+		r.sub_from(dst);
+	}
+
+	void add_to(big_integer &dst) const {
+		l.add_to(dst);
+		r.sub_from(dst);
+	}
+
+	void sub_from(big_integer &dst) const {
+		l.sub_from(dst);
+		r.add_to(dst);
+	}
+};
+
+// Произведение и остаток с целым операндом идут во встроенные *= и %= и в addmul / submul по лимбу,
+// минуя временный big_integer под само целое
+template <typename L, typename R>
+void product_assign(big_integer &dst, L const &l, R const &r) {
+	big_integer lt(dst.get_allocator()), rt(dst.get_allocator());
+	mul(dst, l.eval(lt), r.eval(rt));
+}
+
+template <typename L, typename T>
+void product_assign(big_integer &dst, L const &l, expr_scalar<T> const &r) {
+	l.assign_to(dst);
+	dst *= r.x;
+}
+
+template <typename T, typename R>
+void product_assign(big_integer &dst, expr_scalar<T> const &l, R const &r) {
+	product_assign(dst, r, l);
+}
+
+template <typename L, typename R>
+void product_add(big_integer &dst, L const &l, R const &r, bool subtract) {
+	big_integer lt(dst.get_allocator()), rt(dst.get_allocator());
+	if (subtract) {
+		submul(dst, l.eval(lt), r.eval(rt));
+	} else {
+		addmul(dst, l.eval(lt), r.eval(rt));
+	}
+}
+
+// по лимбу, если |x| в него помещается; иначе произведение считается отдельно и прибавляется целиком
+template <typename L, typename T>
+void product_add(big_integer &dst, L const &l, expr_scalar<T> const &r, bool subtract) {
+	big_integer lt(dst.get_allocator());
+	big_integer const &a = l.eval(lt);
+	bool negative = std::is_signed<T>::value && r.x < 0;
+	uint64_t m = negative ? 0 - static_cast<uint64_t>(r.x) : static_cast<uint64_t>(r.x);
+	if (m > UINT32_MAX) {
+		big_integer p(dst.get_allocator());
+		p = a;
+		p *= r.x;
+		if (subtract) {
+			dst -= p;
+		} else {
+			dst += p;
+		}
+	} else if (subtract != negative) {
+		submul(dst, a, static_cast<big_integer::digit_t>(m));
+	} else {
+		addmul(dst, a, static_cast<big_integer::digit_t>(m));
+	}
+}
+
+template <typename T, typename R>
+void product_add(big_integer &dst, expr_scalar<T> const &l, R const &r, bool subtract) {
+	product_add(dst, r, l, subtract);
+}
+
+template <typename L, typename R>
+void mod_assign(big_integer &dst, L const &l, R const &r) {
+	big_integer rt(dst.get_allocator());
+	big_integer const &m = r.eval(rt);
+	l.assign_to(dst);
+	dst %= m;
+}
+
+template <typename L, typename T>
+void mod_assign(big_integer &dst, L const &l, expr_scalar<T> const &r) {
+	l.assign_to(dst);
+	dst %= r.x;
+}
+
+template <typename L, typename R>
+struct expr_product : expr_node<expr_product<L, R>> {
+	L l;
+	R r;
+
+	expr_product(L l, R r)
+		: l(l), r(r) {}
+
+	big_integer::allocator_type get_allocator() const {
+		return l.get_allocator();
+	}
+
+	bool refers_to(big_integer const *p) const {
+		return l.refers_to(p) || r.refers_to(p);
+	}
+
+	void assign_to(big_integer &dst) const {
+		product_assign(dst, l, r);
+	}
+
+	void add_to(big_integer &dst) const {
+		product_add(dst, l, r, false);
+	}
+
+	void sub_from(big_integer &dst) const {
+		product_add(dst, l, r, true);
+	}
+};
+
+template <typename L, typename R>
+struct expr_mod : expr_node<expr_mod<L, R>> {
+	L l;
+	R r;
+
+	expr_mod(L l, R r)
+		: l(l), r(r) {}
+
+	big_integer::allocator_type get_allocator() const {
+		return l.get_allocator();
+	}
+
+	bool refers_to(big_integer const *p) const {
+		return l.refers_to(p) || r.refers_to(p);
+	}
+
+	void assign_to(big_integer &dst) const {
+		mod_assign(dst, l, r);
+	}
+
+	void add_to(big_integer &dst) const {
+		big_integer tmp(dst.get_allocator());
+		assign_to(tmp);
+		dst += tmp;
+	}
+
+	void sub_from(big_integer &dst) const {
+		big_integer tmp(dst.get_allocator());
+		assign_to(tmp);
+		dst -= tmp;
+	}
+};
+
+template <typename E>
+struct expr_neg : expr_node<expr_neg<E>> {
+	E e;
+
+	explicit expr_neg(E e)
+		: e(e) {}
+
+	big_integer::allocator_type get_allocator() const {
+		return e.get_allocator();
+	}
+
+	bool refers_to(big_integer const *p) const {
+		return e.refers_to(p);
+	}
+
+	void assign_to(big_integer &dst) const {
+		e.assign_to(dst);
+		dst.negate();
+	}
+
+	void add_to(big_integer &dst) const {
+		e.sub_from(dst);
+	}
+
+	void sub_from(big_integer &dst) const {
+		e.add_to(dst);
+	}
+};
+
+template <typename T, typename = void>
+struct expr_operand {
+	static bool constexpr is_number = false;
+	static bool constexpr is_scalar = false;
+};
+
+template <>
+struct expr_operand<big_integer> {
+	static bool constexpr is_number = true;
+	static bool constexpr is_scalar = false;
+	using type = expr_terminal;
+};
+
+template <typename T>
+struct expr_operand<T, std::enable_if_t<std::is_base_of<expr_base<T>, T>::value>> {
+	static bool constexpr is_number = true;
+	static bool constexpr is_scalar = false;
+	using type = T;
+};
+
+// те же встроенные целые, что и у операторов big_integer без шаблонов выражений
+template <typename T>
+struct expr_operand<T, big_integer_native_t<T>> {
+	static bool constexpr is_number = false;
+	static bool constexpr is_scalar = true;
+	using type = expr_scalar<T>;
+};
+
+// хотя бы один из операндов -- big_integer или выражение, другой -- их же или целое
+template <typename L, typename R>
+using expr_enable_t = std::enable_if_t<
+	(expr_operand<L>::is_number || expr_operand<L>::is_scalar) &&
+		(expr_operand<R>::is_number || expr_operand<R>::is_scalar) &&
+		(expr_operand<L>::is_number || expr_operand<R>::is_number)>;
+
+template <typename T>
+typename expr_operand<T>::type as_expr(T const &x) {
+	return typename expr_operand<T>::type(x);
+}
+
+template <typename L, typename R, typename = expr_enable_t<L, R>>
+expr_sum<typename expr_operand<L>::type, typename expr_operand<R>::type> operator+(L const &l, R const &r) {
+	return {as_expr(l), as_expr(r)};
+}
+
+template <typename L, typename R, typename = expr_enable_t<L, R>>
+expr_diff<typename expr_operand<L>::type, typename expr_operand<R>::type> operator-(L const &l, R const &r) {
+	return {as_expr(l), as_expr(r)};
+}
+
+template <typename L, typename R, typename = expr_enable_t<L, R>>
+expr_product<typename expr_operand<L>::type, typename expr_operand<R>::type> operator*(L const &l, R const &r) {
+	return {as_expr(l), as_expr(r)};
+}
+
+template <typename L, typename R, typename = expr_enable_t<L, R>>
+expr_mod<typename expr_operand<L>::type, typename expr_operand<R>::type> operator%(L const &l, R const &r) {
+	return {as_expr(l), as_expr(r)};
+}
+
+template <typename E, typename = std::enable_if_t<std::is_base_of<expr_base<E>, E>::value>>
+expr_neg<E> operator-(E const &e) {
+	return expr_neg<E>(e);
+}
+
+template <typename Expr, typename>
+big_integer &big_integer::operator=(Expr const &e) {
+	if (e.refers_to(this)) {
+		big_integer tmp(get_allocator());
+		e.assign_to(tmp);
+		return *this = std::move(tmp);
+	}
+	e.assign_to(*this);
+	return *this;
+}
+
+template <typename Expr, typename>
+big_integer &big_integer::operator+=(Expr const &e) {
+	if (e.refers_to(this)) {
+		big_integer tmp(get_allocator());
+		e.assign_to(tmp);
+		return *this += tmp;
+	}
+	e.add_to(*this);
+	return *this;
+}
+
+template <typename Expr, typename>
+big_integer &big_integer::operator-=(Expr const &e) {
+	if (e.refers_to(this)) {
+		big_integer tmp(get_allocator());
+		e.assign_to(tmp);
+		return *this -= tmp;
+	}
+	e.sub_from(*this);
+	return *this;
+}
+
+#endif //BIG_INTEGER_EXPR_H
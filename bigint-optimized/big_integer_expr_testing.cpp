@@ -0,0 +1,161 @@
+#include "big_integer_expr.h"
+
+#include <gtest/gtest.h>
+
+#include "limb_pool.h"
+
+namespace {
+big_integer product(big_integer const& a, big_integer const& b) {
+  big_integer res;
+  mul(res, a, b);
+  return res;
+}
+}
+
+TEST(expression_templates, fused_forms) {
+  big_integer a("-123456789012345678901234567890123456789");
+  big_integer b("98765432109876543210987654321");
+  big_integer c("55555555555555555555555555555555555555555555");
+  big_integer d("-31415926535897932384626433832795");
+  big_integer m("1000000000000000000000000000057");
+
+  big_integer r = a * b + c;
+  big_integer expected = product(a, b);
+  expected += c;
+  EXPECT_EQ(expected, r);
+
+  r = c + a * b;
+  EXPECT_EQ(expected, r);
+
+  r = a * b - c * d;
+  expected = product(a, b);
+  expected -= product(c, d);
+  EXPECT_EQ(expected, r);
+
+  r = (a + b) % m;
+  expected = a;
+  expected += b;
+  expected %= m;
+  EXPECT_EQ(expected, r);
+
+  r = a * b * c - (d - a) * 3 + 7;
+  expected = product(product(a, b), c);
+  big_integer t = d;
+  t -= a;
+  expected -= product(t, 3);
+  expected += 7;
+  EXPECT_EQ(expected, r);
+}
+
+TEST(expression_templates, destination_inside_expression) {
+  big_integer a("123456789123456789123456789");
+  big_integer b("-987654321987654321");
+  big_integer r = a;
+  r = r * b + r;
+  big_integer expected = product(a, b);
+  expected += a;
+  EXPECT_EQ(expected, r);
+
+  r = a;
+  r += r * r;
+  expected = product(a, a);
+  expected += a;
+  EXPECT_EQ(expected, r);
+
+  r = b;
+  r -= a * r;
+  expected = b;
+  expected -= product(a, b);
+  EXPECT_EQ(expected, r);
+}
+
+TEST(expression_templates, no_intermediate_allocations) {
+  big_integer a = (big_integer(1) << 3000) - 1;
+  big_integer b = (big_integer(1) << 2000) + 12345;
+  big_integer c = -(big_integer(1) << 2500);
+  big_integer d = (big_integer(1) << 1000) + 1;
+  big_integer m = (big_integer(1) << 1500) + 3;
+  big_integer r = a * b - c * d;
+
+  limb_pool::reset_stats();
+  for (int i = 0; i != 10; ++i) {
+    r = a * b - c * d;
+    r = a * b + c;
+    r = (a + b) % m;
+    r += a * d;
+  }
+  EXPECT_EQ(0u, limb_pool::stats().allocations);
+}
+
+TEST(expression_templates, scalar_operands_do_not_allocate) {
+  big_integer a = (big_integer(1) << 3000) - 1;
+  big_integer r = a * a;
+
+  limb_pool::reset_stats();
+  for (int i = 0; i != 10; ++i) {
+    r = a * 10;
+    r = 10 * a;
+    r = a % 10;
+    r += a * 7;
+    r -= 3u * a;
+    r += a * -5;
+  }
+  EXPECT_EQ(0u, limb_pool::stats().allocations);
+}
+
+TEST(expression_templates, scalar_products_and_remainders) {
+  big_integer a("-123456789012345678901234567890");
+  big_integer c("98765432109876543210");
+  for (int64_t k : {int64_t(0), int64_t(1), int64_t(-1), int64_t(7), int64_t(-7), int64_t(UINT32_MAX),
+                    -int64_t(UINT32_MAX), int64_t(1) << 32, -(int64_t(1) << 40), INT64_MIN}) {
+    big_integer bk;
+    bk = k;
+    big_integer res;
+    res = a * k;
+    EXPECT_EQ(to_string(product(a, bk)), to_string(res));
+    res = k * a;
+    EXPECT_EQ(to_string(product(a, bk)), to_string(res));
+    res = c + a * k;
+    EXPECT_EQ(to_string(c + product(a, bk)), to_string(res));
+    res = c - k * a;
+    EXPECT_EQ(to_string(c - product(a, bk)), to_string(res));
+    res = c - (a + c) * k;
+    EXPECT_EQ(to_string(c - product(a + c, bk)), to_string(res));
+    if (k != 0) {
+      res = a % k;
+      EXPECT_EQ(to_string(a - a / bk * bk), to_string(res));
+    }
+  }
+}
+
+TEST(expression_templates, mixed_with_int_and_plain_operators) {
+  big_integer a = 20;
+  EXPECT_EQ(big_integer(4), big_integer(2) + 2);
+  EXPECT_EQ(big_integer(4), 2 + big_integer(2));
+  EXPECT_TRUE(a * 2 - 1 == 39);
+  EXPECT_EQ(big_integer(7), (a * a) / 57);
+  EXPECT_EQ("-400", to_string(-(a * a)));
+}
+
+TEST(expression_templates, int64_and_uint64_operands) {
+  big_integer a("123456789012345678901234567890");
+  int64_t k = -9000000000000000000;
+  uint64_t u = 18000000000000000000ull;
+  big_integer bk("-9000000000000000000");
+  big_integer bu(u);
+  big_integer res;
+  res = a + k;
+  EXPECT_EQ("123456789003345678901234567890", to_string(res));
+  res = a - u;
+  EXPECT_EQ("123456788994345678901234567890", to_string(res));
+  res = a * k;
+  EXPECT_EQ(to_string(product(a, bk)), to_string(res));
+  res = a * u;
+  EXPECT_EQ(to_string(product(a, bu)), to_string(res));
+  res = a % k;
+  EXPECT_EQ(to_string(a - a / bk * bk), to_string(res));
+  res = a % u;
+  EXPECT_EQ(to_string(a - a / bu * bu), to_string(res));
+  res = k + a * u;
+  EXPECT_EQ(to_string(bk + product(a, bu)), to_string(res));
+}
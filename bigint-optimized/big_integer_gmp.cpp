@@ -183,6 +183,18 @@ bool operator>=(big_integer_gmp const& a, big_integer_gmp const& b) {
   return mpz_cmp(a.mpz, b.mpz) >= 0;
 }
 
+big_integer_gmp powmod(big_integer_gmp const& base, big_integer_gmp const& exp, big_integer_gmp const& mod) {
+  big_integer_gmp res;
+  mpz_powm(res.mpz, base.mpz, exp.mpz, mod.mpz);
+  return res;
+}
+
+big_integer_gmp gcd(big_integer_gmp const& a, big_integer_gmp const& b) {
+  big_integer_gmp res;
+  mpz_gcd(res.mpz, a.mpz, b.mpz);
+  return res;
+}
+
 std::string to_string(big_integer_gmp const& a) {
   char* tmp = mpz_get_str(NULL, 10, a.mpz);
   std::string res = tmp;
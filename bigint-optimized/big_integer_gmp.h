@@ -59,6 +59,9 @@ struct big_integer_gmp {
   friend bool operator>=(big_integer_gmp const& a, big_integer_gmp const& b);
 
   friend std::string to_string(big_integer_gmp const& a);
+  friend big_integer_gmp powmod(big_integer_gmp const& base, big_integer_gmp const& exp, big_integer_gmp const& mod);
+big_integer_gmp gcd(big_integer_gmp const& a, big_integer_gmp const& b);
+  friend big_integer_gmp gcd(big_integer_gmp const& a, big_integer_gmp const& b);
 
  private:
   mpz_t mpz;
@@ -84,6 +87,8 @@ bool operator>(big_integer_gmp const& a, big_integer_gmp const& b);
 bool operator<=(big_integer_gmp const& a, big_integer_gmp const& b);
 bool operator>=(big_integer_gmp const& a, big_integer_gmp const& b);
 
+big_integer_gmp powmod(big_integer_gmp const& base, big_integer_gmp const& exp, big_integer_gmp const& mod);
+
 std::string to_string(big_integer_gmp const& a);
 std::ostream& operator<<(std::ostream& s, big_integer_gmp const& a);
 
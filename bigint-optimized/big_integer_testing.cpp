@@ -6,8 +6,16 @@
 #include <utility>
 #include <gtest/gtest.h>
 
+#include "allocator_resource.h"
+#include "barrett_reducer.h"
 #include "big_integer.h"
 #include "big_integer_gmp.h"
+#include "compact_integer.h"
+#include "limb_arena.h"
+#include "limb_kernels.h"
+#include "limb_pool.h"
+#include "montgomery_context.h"
+#include "scratch_space.h"
 
 TEST(correctness, two_plus_two) {
   EXPECT_EQ(big_integer(4), big_integer(2) + big_integer(2));
@@ -835,3 +843,1347 @@ TEST(correctness_twos_complement, all_ones) {
 
   EXPECT_EQ(to_string(gmp_ans), to_string(your_ans));
 }
+
+TEST(limb_pool, reuses_freed_buffers) {
+  limb_pool::trim();
+  limb_pool::reset_stats();
+  for (int i = 0; i != 100; ++i) {
+    big_integer a = big_integer(1) << 1000;
+    a += 1;
+  }
+  limb_pool::statistics s = limb_pool::stats();
+  EXPECT_GT(s.allocations, 0u);
+  EXPECT_GT(s.hits, 0u);
+  EXPECT_GT(s.hit_rate(), 0.5);
+  EXPECT_GT(s.bytes_retained, 0u);
+}
+
+TEST(limb_pool, retain_limit_and_trim) {
+  limb_pool::set_retain_limit(64);
+  {
+    big_integer a = big_integer(1) << 10000;
+    big_integer b = a * a;
+  }
+  EXPECT_LE(limb_pool::stats().bytes_retained, 64u);
+
+  limb_pool::set_retain_limit(limb_pool::DEFAULT_RETAIN_LIMIT);
+  {
+    big_integer a = big_integer(1) << 10000;
+  }
+  EXPECT_GT(limb_pool::stats().bytes_retained, 0u);
+  limb_pool::trim();
+  EXPECT_EQ(0u, limb_pool::stats().bytes_retained);
+}
+
+TEST(limb_arena, temporaries_do_not_touch_pool) {
+  big_integer outside = big_integer(1) << 500;
+  std::string result;
+  limb_pool::reset_stats();
+  {
+    limb_arena::scope scope;
+    big_integer a = outside;
+    for (int i = 0; i != 100; ++i) {
+      a = a * 3 + i;
+      a %= big_integer("1000000000000000000000000000000000000007");
+    }
+    result = to_string(a);
+    EXPECT_GT(limb_arena::bytes_reserved(), 0u);
+  }
+  EXPECT_EQ(0u, limb_pool::stats().allocations);
+
+  big_integer expected = outside;
+  for (int i = 0; i != 100; ++i) {
+    expected = expected * 3 + i;
+    expected %= big_integer("1000000000000000000000000000000000000007");
+  }
+  EXPECT_EQ(to_string(expected), result);
+}
+
+TEST(limb_arena, nested_scopes) {
+  std::string inner_result, outer_result;
+  {
+    limb_arena::scope outer;
+    big_integer a = big_integer(1) << 3000;
+    size_t reserved = 0;
+    for (int i = 0; i != 2; ++i) {
+      limb_arena::scope inner;
+      big_integer b = a * a;
+      inner_result = to_string(b >> 5999);
+      if (i == 0) {
+        reserved = limb_arena::bytes_reserved();
+      }
+    }
+    EXPECT_EQ(reserved, limb_arena::bytes_reserved());
+    a -= big_integer(1) << 2999;
+    outer_result = to_string(a);
+  }
+  EXPECT_EQ("2", inner_result);
+  EXPECT_EQ(to_string(big_integer(1) << 2999), outer_result);
+  limb_arena::release();
+  EXPECT_EQ(0u, limb_arena::bytes_reserved());
+}
+
+TEST(limb_arena, results_outlive_scope) {
+  big_integer sum, moved, grown = 1;
+  compact_integer compact;
+  {
+    limb_arena::scope scope;
+    big_integer big = big_integer(1) << 5000;
+    sum += big;
+    big_integer tmp = big * 3;
+    moved = std::move(tmp);
+    compact += compact_integer(big);
+    big_integer outer_scope = big - 1;
+    {
+      limb_arena::scope inner;
+      for (int i = 0; i != 100; ++i) {
+        grown *= 1000000007;
+        outer_scope *= 3;
+      }
+      big_integer inner_tmp = outer_scope + 1;
+      outer_scope = std::move(inner_tmp);
+    }
+    {
+      limb_arena::scope inner;
+      big_integer junk = (big_integer(1) << 20000) - 1;
+    }
+    big_integer expected = big - 1;
+    for (int i = 0; i != 100; ++i) {
+      expected *= 3;
+    }
+    EXPECT_EQ(expected + 1, outer_scope);
+  }
+  {
+    // затирает память арены, которую только что освободили
+    limb_arena::scope scope;
+    big_integer junk = (big_integer(1) << 20000) - 1;
+    junk *= junk;
+  }
+  big_integer expected_grown = 1;
+  for (int i = 0; i != 100; ++i) {
+    expected_grown *= 1000000007;
+  }
+  EXPECT_EQ(big_integer(1) << 5000, sum);
+  EXPECT_EQ(big_integer(3) << 5000, moved);
+  EXPECT_EQ(expected_grown, grown);
+  EXPECT_EQ(to_string(big_integer(1) << 5000), to_string(compact));
+  limb_arena::release();
+  sum += 1;
+  moved += 1;
+  EXPECT_EQ((big_integer(1) << 5000) + 1, sum);
+  EXPECT_EQ((big_integer(3) << 5000) + 1, moved);
+}
+
+namespace {
+size_t counted_blocks = 0;
+
+template<typename T>
+struct counting_allocator {
+  using value_type = T;
+
+  counting_allocator() = default;
+  template<typename U>
+  counting_allocator(counting_allocator<U> const&) {}
+
+  T* allocate(size_t n) {
+    counted_blocks += n;
+    return std::allocator<T>().allocate(n);
+  }
+  void deallocate(T* p, size_t n) {
+    counted_blocks -= n;
+    std::allocator<T>().deallocate(p, n);
+  }
+
+  bool operator==(counting_allocator const&) const { return true; }
+  bool operator!=(counting_allocator const&) const { return false; }
+};
+}
+
+TEST(allocator, left_operand_allocator_propagates) {
+  std::pmr::monotonic_buffer_resource arena;
+  big_integer::allocator_type alloc(&arena);
+  big_integer a(big_integer("123456789012345678901234567890"), alloc);
+  big_integer b("987654321098765432109876543210");
+
+  EXPECT_EQ(alloc, (a + b).get_allocator());
+  EXPECT_EQ(alloc, (a * b).get_allocator());
+  EXPECT_EQ(alloc, (a / 7).get_allocator());
+  EXPECT_EQ(alloc, (-a).get_allocator());
+  EXPECT_EQ(alloc, big_integer(a).get_allocator());
+  EXPECT_EQ(big_integer::default_allocator(), (b - a).get_allocator());
+  EXPECT_EQ("121932631137021795226185032733622923332237463801111263526900", to_string(a * b));
+}
+
+TEST(allocator, standard_allocator_adapter) {
+  {
+    allocator_resource<counting_allocator<char>> resource;
+    big_integer::allocator_type alloc(&resource);
+    big_integer a(1, alloc);
+    a <<= 5000;
+    EXPECT_GT(counted_blocks, 0u);
+    big_integer b = a;
+    b -= 1;
+    EXPECT_EQ(a - 1, b);
+  }
+  EXPECT_EQ(0u, counted_blocks);
+}
+
+TEST(scratch_space, division_add_back_step) {
+  // оценка частного на одном из шагов оказывается на единицу больше и требует возврата делителя
+  big_integer a("3138550866962589562912160885581052328266555093128291844096");
+  big_integer b("79228162495817593528424333310");
+  EXPECT_EQ(big_integer("39614081257132168788182040575"), a / b);
+  EXPECT_EQ(big_integer("92233720368547790846"), a % b);
+
+  big_integer c = (big_integer(1) << 200) - 1;
+  big_integer d = (big_integer(1) << 100) + (big_integer(1) << 68);
+  EXPECT_EQ(c, c / d * d + c % d);
+  EXPECT_EQ(-c, -c / d * d + -c % d);
+  EXPECT_LT(-c % d, 0);
+}
+
+TEST(scratch_space, steady_state_reuses_workspace) {
+  big_integer a = (big_integer(1) << 20000) - 1;
+  big_integer b = (big_integer(1) << 9000) + 7;
+  big_integer r = a * b / b;
+  EXPECT_EQ(a, r);
+  size_t reserved = scratch_space::bytes_reserved();
+  EXPECT_GT(reserved, 0u);
+  for (int i = 0; i != 10; ++i) {
+    r = a * b % b;
+  }
+  EXPECT_EQ(reserved, scratch_space::bytes_reserved());
+  EXPECT_EQ(0, r % b);
+}
+
+TEST(out_param, aliasing) {
+  big_integer a("-123456789012345678901234567890123");
+  big_integer b("98765432109876543210");
+  big_integer sum = a + b, diff = a - b, prod = a * b, quot = a / b, rem = a % b;
+
+  big_integer x = a, y = b;
+  add(x, x, y);
+  EXPECT_EQ(sum, x);
+  x = a;
+  add(y, x, y);
+  EXPECT_EQ(sum, y);
+  x = a;
+  add(x, x, x);
+  EXPECT_EQ(a + a, x);
+
+  x = a, y = b;
+  sub(x, x, y);
+  EXPECT_EQ(diff, x);
+  x = a;
+  sub(y, x, y);
+  EXPECT_EQ(diff, y);
+  x = a;
+  sub(x, x, x);
+  EXPECT_EQ(0, x);
+
+  x = a, y = b;
+  mul(y, x, y);
+  EXPECT_EQ(prod, y);
+  y = b;
+  mul(x, x, x);
+  EXPECT_EQ(a * a, x);
+
+  x = a, y = b;
+  divmod(x, y, x, y);
+  EXPECT_EQ(quot, x);
+  EXPECT_EQ(rem, y);
+  x = a, y = b;
+  divmod(y, x, x, y);
+  EXPECT_EQ(quot, y);
+  EXPECT_EQ(rem, x);
+}
+
+TEST(out_param, reuses_capacity) {
+  big_integer a = (big_integer(1) << 3000) - 12345;
+  big_integer b = -(big_integer(1) << 1500) + 777;
+  big_integer res, q, r, zero;
+  mul(res, a, a);
+  divmod(q, r, res, b);
+  add(res, a, b);
+
+  limb_pool::reset_stats();
+  for (int i = 0; i != 10; ++i) {
+    add(res, a, b);
+    sub(res, res, b);
+    EXPECT_EQ(a, res);
+    mul(res, a, b);
+    divmod(q, r, res, b);
+    EXPECT_EQ(a, q);
+    EXPECT_EQ(zero, r);
+  }
+  EXPECT_EQ(0u, limb_pool::stats().allocations);
+}
+
+TEST(move, moved_from_is_zero) {
+  big_integer a("123456789012345678901234567890");
+  big_integer b = std::move(a);
+  EXPECT_EQ(big_integer("123456789012345678901234567890"), b);
+  EXPECT_EQ(0, a);
+  a += 5;
+  EXPECT_EQ(5, a);
+
+  big_integer c = -b;
+  c = std::move(b);
+  EXPECT_EQ(big_integer("123456789012345678901234567890"), c);
+  b = 7;
+  EXPECT_EQ(7, b);
+}
+
+TEST(move, canonical_zero_after_shifts) {
+  EXPECT_EQ(0, big_integer(0) << 64);
+  EXPECT_EQ(-(big_integer(1) << 64), big_integer(-1) << 64);
+  EXPECT_EQ(0, big_integer(5) >> 32);
+  EXPECT_EQ(-1, big_integer(-5) >> 32);
+}
+
+TEST(move, rvalue_operands_reuse_buffers) {
+  big_integer a = (big_integer(1) << 4000) + 1;
+  big_integer b = (big_integer(1) << 4000) - 1;
+  big_integer c = (big_integer(1) << 2000) + 3;
+  big_integer d = (big_integer(1) << 2000) - 3;
+  big_integer e = 12345;
+  big_integer expected = a * b;
+  expected += c * d;
+  expected -= e;
+  EXPECT_EQ(expected, a * b + c * d - e);
+
+  big_integer x = c, y = a;
+  limb_pool::reset_stats();
+  big_integer sum = std::move(x) + std::move(y);
+  big_integer diff = c - std::move(sum);
+  EXPECT_EQ(0u, limb_pool::stats().allocations);
+  EXPECT_EQ(-a, diff);
+
+  y = c;
+  big_integer prod = a * std::move(y);
+  EXPECT_EQ(c * a, prod);
+}
+
+TEST(fused, addmul_submul_random) {
+  std::default_random_engine rng(42);
+  for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+    big_integer_gmp a, b, c;
+    a.random(max_size, rng);
+    b.random(max_size / 2, rng);
+    c.random(max_size / 3, rng);
+    big_integer A(to_string(a)), B(to_string(b)), C(to_string(c));
+    big_integer acc = A;
+    addmul(acc, B, C);
+    EXPECT_EQ(to_string(a + b * c), to_string(acc));
+    acc = A;
+    submul(acc, B, C);
+    EXPECT_EQ(to_string(a - b * c), to_string(acc));
+  }
+}
+
+TEST(fused, single_limb_and_aliasing) {
+  big_integer a("-123456789012345678901234567890123");
+  big_integer b("98765432109876543210");
+  big_integer x = a;
+  addmul(x, b, 4000000000u);
+  EXPECT_EQ(a + b * big_integer(4000000000u), x);
+  x = a;
+  submul(x, a, 7u);
+  EXPECT_EQ(a - a * 7, x);
+  x = b;
+  addmul(x, x, x);
+  EXPECT_EQ(b + b * b, x);
+  x = a;
+  submul(x, b, x);
+  EXPECT_EQ(a - b * a, x);
+  x = -b * b;
+  addmul(x, b, b);
+  EXPECT_EQ(0, x);
+  x = 5;
+  submul(x, big_integer(0), b);
+  EXPECT_EQ(5, x);
+}
+
+TEST(fused, horner_reuses_accumulator) {
+  big_integer x = (big_integer(1) << 200) + 12345;
+  std::vector<big_integer> coefficients;
+  for (int i = 0; i != 8; ++i) {
+    coefficients.push_back((big_integer(i + 1) << (32 * i)) - i);
+  }
+  big_integer expected = 0;
+  for (big_integer const &k : coefficients) {
+    expected = expected * x + k;
+  }
+
+  big_integer acc, tmp, zero;
+  for (int pass = 0; pass != 2; ++pass) {
+    // на втором проходе буферы acc и tmp уже достаточно велики
+    limb_pool::reset_stats();
+    acc = zero;
+    tmp = zero;
+    for (big_integer const &k : coefficients) {
+      tmp = k;
+      addmul(tmp, acc, x);
+      std::swap(acc, tmp);
+    }
+    EXPECT_EQ(expected, acc);
+  }
+  EXPECT_EQ(0u, limb_pool::stats().allocations);
+}
+
+TEST(native, arithmetic_matches_big_integer) {
+  std::vector<big_integer> values = {
+      big_integer(0), big_integer(1), big_integer(-1), big_integer("4294967295"), big_integer("-4294967296"),
+      big_integer("18446744073709551615"), big_integer("-18446744073709551616"),
+      big_integer("123456789012345678901234567890"), big_integer("-123456789012345678901234567890")};
+  std::vector<int64_t> signed_values = {0, 1, -1, 7, -10, 4294967295ll, -4294967296ll, INT64_MAX, INT64_MIN};
+  std::vector<uint64_t> unsigned_values = {0, 1, 10, 4294967296ull, UINT64_MAX};
+  for (big_integer const &a : values) {
+    for (int64_t x : signed_values) {
+      big_integer b(std::to_string(x));
+      EXPECT_EQ(a + b, a + x);
+      EXPECT_EQ(a - b, a - x);
+      EXPECT_EQ(a * b, a * x);
+      if (x != 0) {
+        EXPECT_EQ(a / b, a / x);
+        EXPECT_EQ(a % b, a % x);
+      }
+      EXPECT_EQ(a.compare_to(b), a.compare_to(x));
+      EXPECT_EQ(a < b, a < x);
+      EXPECT_EQ(b == a, x == a);
+    }
+    for (uint64_t x : unsigned_values) {
+      big_integer b(std::to_string(x));
+      EXPECT_EQ(a + b, a + x);
+      EXPECT_EQ(a - b, a - x);
+      EXPECT_EQ(a * b, a * x);
+      if (x != 0) {
+        EXPECT_EQ(a / b, a / x);
+        EXPECT_EQ(a % b, a % x);
+      }
+      EXPECT_EQ(a >= b, a >= x);
+      EXPECT_EQ(b != a, x != a);
+    }
+  }
+  EXPECT_THROW(big_integer(5) / 0, std::runtime_error);
+  EXPECT_THROW(big_integer(5) % 0u, std::runtime_error);
+}
+
+TEST(native, counters_do_not_allocate) {
+  big_integer a = (big_integer(1) << 1000) - 3;
+  big_integer b = -(big_integer(1) << 1000) + 3;
+  big_integer expected_a = ((a + 1000) * 1000000 + 1000000) / 1000;
+  big_integer expected_b = ((b - 1000) * 1000000 - 1000000) / 1000;
+  // запас ёмкости под лишний лимб произведения
+  a *= 1000000;
+  a /= 1000000;
+  b *= 1000000;
+  b /= 1000000;
+  limb_pool::reset_stats();
+  for (int i = 0; i != 1000; ++i) {
+    a += 1;
+    b -= 1u;
+  }
+  a *= 1000000;
+  b *= int64_t(1000000);
+  a += 1000 * 1000;
+  b -= 1000 * 1000;
+  a /= 1000u;
+  b /= 1000;
+  EXPECT_EQ(0u, limb_pool::stats().allocations);
+  EXPECT_EQ(expected_a, a);
+  EXPECT_EQ(expected_b, b);
+  EXPECT_TRUE(a > 0 && 0 > b && a != 0u);
+}
+
+TEST(increment, carry_ripple_across_limbs) {
+  big_integer a = (big_integer(1) << 96) - 1;
+  EXPECT_EQ(big_integer(1) << 96, ++a);
+  EXPECT_EQ((big_integer(1) << 96) - 1, --a);
+  big_integer b = -(big_integer(1) << 64);
+  EXPECT_EQ(-(big_integer(1) << 64) - 1, --b);
+  EXPECT_EQ(-(big_integer(1) << 64), ++b);
+
+  big_integer c = -2;
+  EXPECT_EQ(-1, ++c);
+  EXPECT_EQ(0, ++c);
+  EXPECT_EQ(1, ++c);
+  EXPECT_EQ(0, --c);
+  EXPECT_EQ(-1, --c);
+  EXPECT_EQ(-2, --c);
+  EXPECT_EQ(-2, c++);
+  EXPECT_EQ(-1, c--);
+}
+
+TEST(increment, negate_single_pass) {
+  std::vector<big_integer> values = {
+      big_integer(0), big_integer(1), big_integer(-1), big_integer("4294967296"), big_integer("-4294967296"),
+      big_integer("2147483648"), big_integer("-2147483648"), big_integer("18446744073709551616"),
+      big_integer("-123456789012345678901234567890")};
+  for (big_integer const &a : values) {
+    big_integer b = a;
+    b.negate();
+    EXPECT_EQ(0, a + b);
+    EXPECT_EQ(big_integer(0) - a, b);
+    b.negate();
+    EXPECT_EQ(a, b);
+  }
+}
+
+TEST(increment, counter_does_not_allocate) {
+  big_integer a = (big_integer(1) << 2000) - 500;
+  big_integer b = -a;
+  limb_pool::reset_stats();
+  for (int i = 0; i != 1000; ++i) {
+    ++a;
+    --b;
+    a.negate();
+    a.negate();
+  }
+  EXPECT_EQ(0u, limb_pool::stats().allocations);
+  EXPECT_EQ((big_integer(1) << 2000) + 500, a);
+  EXPECT_EQ(-(big_integer(1) << 2000) - 500, b);
+}
+
+TEST(montgomery, matches_plain_modular_arithmetic) {
+  std::default_random_engine rng(42);
+  std::vector<big_integer> moduli = {
+      big_integer(1), big_integer(3), big_integer("4294967291"), big_integer("18446744073709551557"),
+      (big_integer(1) << 255) - 19, (big_integer(1) << 1024) - 1,
+      big_integer("340282366920938463463374607431768211297"),
+      // нечётное число лимбов: последний шаг редукции -- по одному лимбу
+      (big_integer(1) << 96) - 17, (big_integer(1) << 160) - 47, (big_integer(1) << 1056) - 1};
+  for (big_integer const &m : moduli) {
+    montgomery_context ctx(m);
+    for (size_t itn = 0; itn != 20; ++itn) {
+      big_integer_gmp x, y;
+      x.random(1200, rng);
+      y.random(1200, rng);
+      big_integer a(to_string(x)), b(to_string(y));
+      big_integer ra = (a % m + m) % m, rb = (b % m + m) % m;
+      big_integer ma = ctx.to_montgomery(a), mb = ctx.to_montgomery(b);
+      EXPECT_EQ(ra, ctx.from_montgomery(ma));
+
+      big_integer res;
+      ctx.mul(res, ma, mb);
+      EXPECT_EQ(ra * rb % m, ctx.from_montgomery(res));
+      ctx.sqr(res, ma);
+      EXPECT_EQ(ra * ra % m, ctx.from_montgomery(res));
+      ctx.add(res, ma, mb);
+      EXPECT_EQ((ra + rb) % m, ctx.from_montgomery(res));
+      ctx.sub(res, ma, mb);
+      EXPECT_EQ(((ra - rb) % m + m) % m, ctx.from_montgomery(res));
+    }
+  }
+}
+
+TEST(montgomery, chain_with_aliasing) {
+  big_integer m = (big_integer(1) << 521) - 1;
+  montgomery_context ctx(m);
+  big_integer base = big_integer("123456789123456789123456789");
+  big_integer expected = 1;
+  big_integer acc = ctx.one(), x = ctx.to_montgomery(base);
+  for (int i = 0; i != 100; ++i) {
+    expected = expected * base % m;
+    ctx.mul(acc, acc, x);
+    EXPECT_LT(acc, m);
+  }
+  EXPECT_EQ(expected, ctx.from_montgomery(acc));
+  ctx.sqr(acc, acc);
+  ctx.add(acc, acc, acc);
+  ctx.sub(acc, acc, x);
+  EXPECT_EQ(((expected * expected * 2 - base) % m + m) % m, ctx.from_montgomery(acc));
+
+  EXPECT_THROW(montgomery_context(big_integer(10)), std::runtime_error);
+  EXPECT_THROW(montgomery_context(big_integer(-7)), std::runtime_error);
+}
+
+TEST(power, pow_small_cases) {
+  EXPECT_EQ(1, pow(big_integer(0), big_integer(0)));
+  EXPECT_EQ(0, pow(big_integer(0), big_integer(5)));
+  EXPECT_EQ(big_integer(1) << 1000, pow(big_integer(2), big_integer(1000)));
+  EXPECT_EQ(-(big_integer(1) << 999), pow(big_integer(-2), big_integer(999)));
+  EXPECT_EQ(big_integer("515377520732011331036461129765621272702107522001"), pow(big_integer(3), big_integer(100)));
+  big_integer p = 1;
+  for (int i = 0; i != 77; ++i) {
+    p *= 123456789;
+  }
+  EXPECT_EQ(p, pow(big_integer(123456789), big_integer(77)));
+  EXPECT_THROW(pow(big_integer(2), big_integer(-1)), std::runtime_error);
+}
+
+TEST(power, powmod_matches_gmp) {
+  std::default_random_engine rng(42);
+  for (size_t itn = 0; itn != 60; ++itn) {
+    big_integer_gmp b, e, m;
+    b.random(700, rng);
+    e.random(300, rng);
+    m.random(500, rng);
+    if (e < big_integer_gmp(0)) {
+      e = -e;
+    }
+    if (m < big_integer_gmp(0)) {
+      m = -m;
+    }
+    if (itn % 2 == 0) {
+      m |= big_integer_gmp(1);
+    } else {
+      m >>= 1;
+      m <<= 1;
+    }
+    if (m == big_integer_gmp(0)) {
+      continue;
+    }
+    big_integer res = powmod(big_integer(to_string(b)), big_integer(to_string(e)), big_integer(to_string(m)));
+    EXPECT_EQ(to_string(powmod(b, e, m)), to_string(res));
+  }
+  EXPECT_EQ(0, powmod(big_integer(5), big_integer(3), big_integer(1)));
+  EXPECT_EQ(1, powmod(big_integer(5), big_integer(0), big_integer(7)));
+  EXPECT_EQ(6, powmod(big_integer(-1), big_integer(3), big_integer(-7)));
+  EXPECT_THROW(powmod(big_integer(5), big_integer(3), big_integer(0)), std::runtime_error);
+}
+
+TEST(barrett, matches_operator_mod) {
+  std::default_random_engine rng(42);
+  for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+    big_integer_gmp x, y;
+    x.random(max_size, rng);
+    y.random(max_size / 2, rng);
+    big_integer a(to_string(x)), d(to_string(y));
+    if (d == 0) {
+      continue;
+    }
+    barrett_reducer reducer(d);
+    big_integer r;
+    reducer.reduce(r, a);
+    EXPECT_EQ(a % d, r);
+    big_integer sq = a % d * (a % d);
+    reducer.reduce(r, sq);
+    EXPECT_EQ(sq % d, r);
+  }
+}
+
+TEST(barrett, edge_divisors) {
+  std::vector<big_integer> divisors = {
+      big_integer(1), big_integer(-2), big_integer(1) << 32, big_integer(1) << 64, (big_integer(1) << 64) - 1,
+      big_integer("1000000000000000000000000000000"), -(big_integer(1) << 200)};
+  for (big_integer const &d : divisors) {
+    barrett_reducer reducer(d);
+    big_integer abs_d = d < 0 ? -d : d;
+    EXPECT_EQ(abs_d, reducer.modulus());
+    std::vector<big_integer> values = {
+        big_integer(0), abs_d - 1, abs_d, abs_d + 1, -abs_d, abs_d * abs_d - 1, -(abs_d * abs_d) + 1,
+        abs_d * abs_d * abs_d + 12345};
+    for (big_integer const &x : values) {
+      big_integer r = x;
+      reducer.reduce(r, r);
+      EXPECT_EQ(x % d, r);
+    }
+  }
+  EXPECT_THROW(barrett_reducer(big_integer(0)), std::runtime_error);
+}
+
+TEST(divisor, matches_long_division) {
+  std::default_random_engine rng(42);
+  std::vector<uint64_t> values = {1, 2, 3, 7, 10, 1000000000, 2147483648ull, 4294967295ull, 4294967296ull,
+                                  4294967297ull, 10000000000000000000ull, 9223372036854775808ull, UINT64_MAX};
+  for (uint64_t x : values) {
+    divisor d(x);
+    big_integer b(x);
+    for (size_t itn = 0; itn != 20; ++itn) {
+      big_integer_gmp g;
+      g.random(max_size, rng);
+      big_integer a(to_string(g));
+      big_integer q, r;
+      divmod(q, r, a, d);
+      EXPECT_EQ(a / b, q);
+      EXPECT_EQ(a % b, r);
+      EXPECT_EQ(a / b, a / d);
+      EXPECT_EQ(a % b, a % d);
+      big_integer c = a;
+      divmod(c, r, c, d);
+      EXPECT_EQ(a / b, c);
+      c = a;
+      c %= d;
+      EXPECT_EQ(a % b, c);
+    }
+  }
+  EXPECT_THROW(divisor(0), std::runtime_error);
+}
+
+TEST(divisor, two_limb_division_by_big_integer) {
+  big_integer a("123456789012345678901234567890123456789012345678901234567890");
+  big_integer b("18446744073709551557");
+  EXPECT_EQ(big_integer("6692605942763486939073081748053749750631"), a / b);
+  EXPECT_EQ(big_integer("14898563589646785423"), a % b);
+  EXPECT_EQ(big_integer("-6692605942763486939073081748053749750631"), -a / b);
+  EXPECT_EQ(big_integer("-14898563589646785423"), -a % b);
+}
+
+// частное длиной почти в целый кусок scratch_space: запись за его конец ловит ASan
+TEST(divisor, two_limb_division_of_long_dividend) {
+  big_integer a = (big_integer(1) << (32 * 4097 - 1)) + 12345;
+  big_integer b = (big_integer(1) << 63) + 7;
+  for (int i = 0; i < 4; ++i) {
+    big_integer q = a / b;
+    big_integer r = a % b;
+    EXPECT_EQ(a, q * b + r);
+    EXPECT_TRUE(r >= 0 && r < b);
+    a += b * i;
+  }
+}
+
+TEST(divexact, matches_division) {
+  std::default_random_engine rng(42);
+  for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+    big_integer_gmp x, y;
+    x.random(max_size / 2, rng);
+    y.random(max_size / 2, rng);
+    big_integer a(to_string(x)), b(to_string(y));
+    if (b == 0) {
+      continue;
+    }
+    b <<= static_cast<int>(itn % 70);
+    big_integer p = a * b;
+    EXPECT_EQ(a, divexact(p, b));
+    EXPECT_TRUE(divisible(p, b));
+    EXPECT_EQ((p + 1) % b == 0, divisible(p + 1, b));
+    EXPECT_EQ((p - b / 2) % b == 0, divisible(p - b / 2, b));
+  }
+}
+
+TEST(divexact, edge_cases) {
+  EXPECT_EQ(0, divexact(big_integer(0), big_integer(7)));
+  EXPECT_EQ(-3, divexact(big_integer(21), big_integer(-7)));
+  EXPECT_EQ(big_integer(1) << 100, divexact(-(big_integer(1) << 164), -(big_integer(1) << 64)));
+  EXPECT_THROW(divexact(big_integer(5), big_integer(0)), std::runtime_error);
+  EXPECT_TRUE(divisible(big_integer(0), big_integer(0)));
+  EXPECT_FALSE(divisible(big_integer(5), big_integer(0)));
+  EXPECT_FALSE(divisible(big_integer(5), big_integer(10)));
+  EXPECT_FALSE(divisible(big_integer(1) << 64, big_integer(3) << 64));
+  EXPECT_TRUE(divisible(big_integer(6) << 64, big_integer(3) << 60));
+
+  EXPECT_TRUE(divisible_2exp(big_integer(0), 1000));
+  EXPECT_TRUE(divisible_2exp(big_integer(5), 0));
+  EXPECT_FALSE(divisible_2exp(big_integer(5), 1));
+  EXPECT_TRUE(divisible_2exp(-(big_integer(1) << 64), 64));
+  EXPECT_FALSE(divisible_2exp(-(big_integer(1) << 64), 65));
+  EXPECT_TRUE(divisible_2exp(big_integer(3) << 70, 70));
+  EXPECT_FALSE(divisible_2exp(big_integer(3) << 70, 71));
+  EXPECT_TRUE(divisible_2exp(big_integer(-8), 3));
+  EXPECT_FALSE(divisible_2exp(big_integer(-8), 4));
+  EXPECT_FALSE(divisible_2exp(big_integer(-1), 1000));
+}
+
+TEST(gcd, matches_gmp) {
+  std::default_random_engine rng(42);
+  for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+    big_integer_gmp x, y, z;
+    x.random(max_size / 2, rng);
+    y.random(max_size / 2, rng);
+    z.random(itn % 4 == 0 ? max_size / 4 : 1, rng);
+    x *= z;
+    y *= z;
+    big_integer a(to_string(x)), b(to_string(y));
+    big_integer g(to_string(gcd(x, y)));
+    EXPECT_EQ(g, gcd(a, b));
+
+    big_integer g2, s, t;
+    gcdext(g2, s, t, a, b);
+    EXPECT_EQ(g, g2);
+    EXPECT_EQ(g, a * s + b * t);
+  }
+}
+
+TEST(gcd, edge_cases) {
+  EXPECT_EQ(0, gcd(big_integer(0), big_integer(0)));
+  EXPECT_EQ(5, gcd(big_integer(0), big_integer(-5)));
+  EXPECT_EQ(6, gcd(big_integer(-12), big_integer(18)));
+  EXPECT_EQ(big_integer(1) << 70, gcd(big_integer(3) << 70, big_integer(1) << 100));
+  EXPECT_EQ(1, gcd((big_integer(1) << 127) - 1, (big_integer(1) << 89) - 1));
+
+  big_integer g, s, t;
+  gcdext(g, s, t, big_integer(-7), big_integer(0));
+  EXPECT_EQ(7, g);
+  EXPECT_EQ(-7 * s, g);
+  gcdext(g, s, t, big_integer(240), big_integer(-46));
+  EXPECT_EQ(2, g);
+  EXPECT_EQ(240 * s - 46 * t, g);
+
+  big_integer m = (big_integer(1) << 127) - 1;
+  big_integer a("123456789012345678901234567890");
+  big_integer x = invert(a, m);
+  EXPECT_EQ(1, a * x % m);
+  EXPECT_TRUE(x >= 0 && x < m);
+  EXPECT_EQ(1, (-a) * invert(-a, -m) % m + m);
+  EXPECT_EQ(0, invert(big_integer(5), big_integer(1)));
+  EXPECT_THROW(invert(big_integer(6), big_integer(9)), std::runtime_error);
+  EXPECT_THROW(invert(big_integer(6), big_integer(0)), std::runtime_error);
+}
+
+TEST(root, bounds) {
+  std::default_random_engine rng(42);
+  for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+    big_integer_gmp x;
+    x.random(itn % 2 == 0 ? max_size / 2 : 3, rng);
+    big_integer a(to_string(x));
+    if (a < 0) {
+      a = -a;
+    }
+    big_integer s, r;
+    isqrt_rem(s, r, a);
+    EXPECT_EQ(a, s * s + r);
+    EXPECT_TRUE(r >= 0 && r <= 2 * s);
+
+    unsigned k = 3 + itn % 5;
+    big_integer t = iroot(a, k);
+    EXPECT_TRUE(pow(t, k) <= a);
+    EXPECT_TRUE(pow(t + 1, k) > a);
+  }
+}
+
+TEST(root, edge_cases) {
+  EXPECT_EQ(0, isqrt(big_integer(0)));
+  EXPECT_EQ(1, isqrt(big_integer(3)));
+  EXPECT_EQ(2, isqrt(big_integer(4)));
+  EXPECT_EQ(4294967295u, isqrt(big_integer(UINT64_MAX)));
+  EXPECT_EQ(big_integer(1) << 32, isqrt(big_integer(1) << 64));
+  EXPECT_EQ((big_integer(1) << 100) - 1, isqrt((big_integer(1) << 200) - 1));
+  EXPECT_THROW(isqrt(big_integer(-1)), std::runtime_error);
+
+  EXPECT_EQ(-3, iroot(big_integer(-27), 3));
+  EXPECT_EQ(-2, iroot(big_integer(-26), 3));
+  EXPECT_EQ(big_integer(1) << 50, iroot(big_integer(1) << 350, 7));
+  EXPECT_EQ(1, iroot((big_integer(1) << 100) - 1, 100));
+  EXPECT_EQ(2, iroot(big_integer(1) << 100, 100));
+  EXPECT_EQ(12345, iroot(big_integer(12345), 1));
+  EXPECT_THROW(iroot(big_integer(-16), 4), std::runtime_error);
+  EXPECT_THROW(iroot(big_integer(16), 0), std::runtime_error);
+}
+
+TEST(bits, matches_shifts_and_masks) {
+  std::default_random_engine rng(42);
+  for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+    big_integer_gmp x;
+    x.random(max_size / 8, rng);
+    big_integer a(to_string(x));
+    size_t k = rng() % (32 * a.size() + 70);
+    size_t len = rng() % 100;
+    big_integer one = 1;
+    EXPECT_EQ(((a >> static_cast<int>(k)) & 1) != 0, a.test_bit(k));
+    EXPECT_EQ((a >> static_cast<int>(k)) & ((one << static_cast<int>(len)) - 1), a.extract_bits(k, len));
+
+    big_integer b = a;
+    b.set_bit(k);
+    EXPECT_EQ(a | (one << static_cast<int>(k)), b);
+    b = a;
+    b.clear_bit(k);
+    EXPECT_EQ(a & ~(one << static_cast<int>(k)), b);
+    b = a;
+    b.flip_bit(k);
+    EXPECT_EQ(a ^ (one << static_cast<int>(k)), b);
+    b.flip_bit(k);
+    EXPECT_EQ(a, b);
+
+    big_integer m = a < 0 ? ~a : a;
+    EXPECT_TRUE(m < (one << static_cast<int>(a.bit_length())));
+    EXPECT_TRUE(a.bit_length() == 0 || m >= (one << static_cast<int>(a.bit_length() - 1)));
+    if (a != 0) {
+      size_t z = a.countr_zero();
+      EXPECT_TRUE(a.test_bit(z));
+      EXPECT_EQ(0, a % (one << static_cast<int>(z)));
+    }
+  }
+}
+
+TEST(bits, edge_cases) {
+  big_integer a;
+  EXPECT_EQ(0u, a.bit_length());
+  EXPECT_EQ(0u, a.popcount());
+  EXPECT_EQ(SIZE_MAX, a.countr_zero());
+  a.set_bit(100);
+  EXPECT_EQ(big_integer(1) << 100, a);
+  EXPECT_EQ(101u, a.bit_length());
+  a.clear_bit(100);
+  EXPECT_EQ(0, a);
+  EXPECT_EQ(0u, a.size());
+
+  big_integer m(-1);
+  EXPECT_EQ(0u, m.bit_length());
+  EXPECT_EQ(0u, m.popcount());
+  EXPECT_EQ(0u, m.countr_zero());
+  EXPECT_EQ(32u, (-(big_integer(1) << 32)).countr_zero());
+  EXPECT_EQ(64u, (-(big_integer(1) << 64)).countr_zero());
+  EXPECT_TRUE(m.test_bit(1000));
+  m.set_bit(1000);
+  EXPECT_EQ(0u, m.size());
+  m.clear_bit(0);
+  EXPECT_EQ(-2, m);
+  m.flip_bit(0);
+  EXPECT_EQ(-1, m);
+  m.clear_bit(64);
+  EXPECT_EQ(-1 - (big_integer(1) << 64), m);
+  EXPECT_EQ(65u, m.bit_length());
+  EXPECT_EQ(1u, m.popcount());
+
+  big_integer n = -(big_integer(1) << 70);
+  EXPECT_EQ(70u, n.countr_zero());
+  EXPECT_EQ(70u, n.bit_length());
+  EXPECT_EQ(70u, n.popcount());
+  EXPECT_EQ(255, n.extract_bits(200, 8));
+  EXPECT_EQ(0, n.extract_bits(0, 70));
+  EXPECT_EQ(2, n.extract_bits(69, 2));
+  EXPECT_EQ(4u, big_integer(0xf0).popcount());
+}
+
+TEST(shifts, shl_shr_match_operators) {
+  std::default_random_engine rng(42);
+  for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+    big_integer_gmp x;
+    x.random(max_size / 8, rng);
+    big_integer a(to_string(x));
+    size_t k = rng() % 200;
+    big_integer expected_l = a * pow(big_integer(2), big_integer(static_cast<int>(k)));
+    big_integer expected_r = a >= 0 ? a / pow(big_integer(2), big_integer(static_cast<int>(k)))
+                                    : -((-a - 1) / pow(big_integer(2), big_integer(static_cast<int>(k)))) - 1;
+    big_integer r;
+    shl(r, a, k);
+    EXPECT_EQ(expected_l, r);
+    shr(r, a, k);
+    EXPECT_EQ(expected_r, r);
+    EXPECT_EQ(expected_l, a << static_cast<int>(k));
+    EXPECT_EQ(expected_r, a >> static_cast<int>(k));
+
+    big_integer b = a;
+    shl(b, b, k);
+    EXPECT_EQ(expected_l, b);
+    shr(b, b, k);
+    EXPECT_EQ(a, b);
+    shr(b, b, k);
+    EXPECT_EQ(expected_r, b);
+  }
+}
+
+TEST(shifts, edge_cases) {
+  big_integer r;
+  shl(r, big_integer(-1), 0);
+  EXPECT_EQ(-1, r);
+  shl(r, big_integer(-1), 64);
+  EXPECT_EQ(-(big_integer(1) << 64), r);
+  shl(r, big_integer(0), 1000);
+  EXPECT_EQ(0, r);
+  EXPECT_EQ(0u, r.size());
+  shr(r, big_integer(-5), 1000);
+  EXPECT_EQ(-1, r);
+  shr(r, big_integer(-5), 1);
+  EXPECT_EQ(-3, r);
+  shr(r, -(big_integer(1) << 96), 96);
+  EXPECT_EQ(-1, r);
+  shr(r, (big_integer(1) << 96) - 1, 64);
+  EXPECT_EQ(UINT32_MAX, r);
+  EXPECT_EQ(big_integer(1) << 10, (big_integer(1) << 100) >> 90);
+  EXPECT_EQ(big_integer(1) << 10, (big_integer(1) << 100) << -90);
+}
+
+TEST(bitwise, all_lengths_and_signs) {
+  // длины вокруг ширины векторов и хвосты под маской
+  for (int n = 0; n <= 40; ++n) {
+    for (int m : {0, 1, 3, 7, 8, 15, 16, 17, 33}) {
+      for (int signs = 0; signs < 4; ++signs) {
+        big_integer a = (big_integer(0x5a5a5a5a) << (32 * n)) / 3 + n;
+        big_integer b = (big_integer(0x0ff00ff0) << (32 * m)) / 7 + m;
+        if (signs & 1) {
+          a = -a;
+        }
+        if (signs & 2) {
+          b = -b;
+        }
+        big_integer_gmp ga(to_string(a)), gb(to_string(b));
+        EXPECT_EQ(to_string(ga & gb), to_string(a & b));
+        EXPECT_EQ(to_string(ga | gb), to_string(a | b));
+        EXPECT_EQ(to_string(ga ^ gb), to_string(a ^ b));
+        EXPECT_EQ(to_string(~ga), to_string(~a));
+        EXPECT_EQ(-a - 1, ~a);
+        big_integer c = a;
+        c.clear_bits(b);
+        EXPECT_EQ(to_string(ga & ~gb), to_string(c));
+      }
+    }
+  }
+}
+
+TEST(bitwise, aliasing) {
+  big_integer a = -(big_integer(12345) << 300) + 77;
+  big_integer b = a;
+  b &= b;
+  EXPECT_EQ(a, b);
+  b |= b;
+  EXPECT_EQ(a, b);
+  b ^= b;
+  EXPECT_EQ(0, b);
+  EXPECT_EQ(0u, b.size());
+  b = a;
+  b.clear_bits(b);
+  EXPECT_EQ(0, b);
+}
+
+TEST(kernels, bitwise_tiers_match_scalar) {
+  // длины не кратны ни одной ширине вектора: хвосты идут скалярно или под маской
+  using limb_t = limb_kernels::limb_t;
+  using tier = limb_kernels::bitwise_tier;
+  std::default_random_engine rng(45);
+  limb_kernels::bitwise_table scalar = limb_kernels::table(tier::scalar);
+  for (tier t : {tier::sse2, tier::avx2, tier::avx512}) {
+    if (!limb_kernels::available(t)) {
+      continue;
+    }
+    limb_kernels::bitwise_table simd = limb_kernels::table(t);
+    for (size_t n = 0; n <= 70; ++n) {
+      std::vector<limb_t> a(n + 1), b(n + 1);
+      for (size_t i = 0; i <= n; ++i) {
+        a[i] = static_cast<limb_t>(rng());
+        b[i] = static_cast<limb_t>(rng());
+      }
+      for (auto fn : {&limb_kernels::bitwise_table::and_n, &limb_kernels::bitwise_table::ior_n,
+                      &limb_kernels::bitwise_table::xor_n, &limb_kernels::bitwise_table::andn_n,
+                      &limb_kernels::bitwise_table::com}) {
+        // лимб за концом должен остаться нетронутым
+        std::vector<limb_t> expected(n + 1, 0xdeadbeef), res(n + 1, 0xdeadbeef);
+        (scalar.*fn)(expected.data(), a.data(), b.data(), n);
+        (simd.*fn)(res.data(), a.data(), b.data(), n);
+        ASSERT_EQ(expected, res) << static_cast<int>(t) << " " << n;
+        res = a;
+        (simd.*fn)(res.data(), res.data(), b.data(), n);
+        ASSERT_TRUE(std::equal(res.begin(), res.begin() + n, expected.begin())) << static_cast<int>(t) << " " << n;
+        res = b;
+        (simd.*fn)(res.data(), a.data(), res.data(), n);
+        ASSERT_TRUE(std::equal(res.begin(), res.begin() + n, expected.begin())) << static_cast<int>(t) << " " << n;
+      }
+    }
+  }
+}
+
+TEST(kernels, match_reference) {
+  // чётные и нечётные длины: выбранные по процессору версии работают словами из двух лимбов
+  std::default_random_engine rng(42);
+  using limb_t = limb_kernels::limb_t;
+  for (size_t n = 0; n <= 21; ++n) {
+    for (int itn = 0; itn < 20; ++itn) {
+      std::vector<limb_t> a(n), b(n), r(n), expected(n);
+      for (size_t i = 0; i < n; ++i) {
+        a[i] = itn % 5 == 0 ? UINT32_MAX : static_cast<limb_t>(rng());
+        b[i] = itn % 7 == 0 ? UINT32_MAX : static_cast<limb_t>(rng());
+        r[i] = itn % 3 == 0 ? UINT32_MAX : static_cast<limb_t>(rng());
+      }
+      limb_t m = itn % 4 == 0 ? UINT32_MAX : static_cast<limb_t>(rng());
+
+      uint64_t carry = 0;
+      for (size_t i = 0; i < n; ++i) {
+        carry += static_cast<uint64_t>(a[i]) + b[i];
+        expected[i] = static_cast<limb_t>(carry);
+        carry >>= 32u;
+      }
+      std::vector<limb_t> res(n);
+      EXPECT_EQ(carry, limb_kernels::add_n(res.data(), a.data(), b.data(), n));
+      EXPECT_EQ(expected, res);
+
+      uint64_t borrow = 0;
+      for (size_t i = 0; i < n; ++i) {
+        uint64_t t = static_cast<uint64_t>(a[i]) - b[i] - borrow;
+        expected[i] = static_cast<limb_t>(t);
+        borrow = (t >> 32u) & 1u;
+      }
+      res = a;
+      EXPECT_EQ(borrow, limb_kernels::sub_n(res.data(), res.data(), b.data(), n));
+      EXPECT_EQ(expected, res);
+      res = b;
+      EXPECT_EQ(borrow, limb_kernels::sub_n(res.data(), a.data(), res.data(), n));
+      EXPECT_EQ(expected, res);
+
+      carry = 0;
+      for (size_t i = 0; i < n; ++i) {
+        carry += static_cast<uint64_t>(a[i]) * m;
+        expected[i] = static_cast<limb_t>(carry);
+        carry >>= 32u;
+      }
+      EXPECT_EQ(carry, limb_kernels::mul_1(res.data(), a.data(), n, m));
+      EXPECT_EQ(expected, res);
+
+      carry = 0;
+      for (size_t i = 0; i < n; ++i) {
+        carry += static_cast<uint64_t>(a[i]) * m + r[i];
+        expected[i] = static_cast<limb_t>(carry);
+        carry >>= 32u;
+      }
+      res = r;
+      EXPECT_EQ(carry, limb_kernels::addmul_1(res.data(), a.data(), n, m));
+      EXPECT_EQ(expected, res);
+
+      carry = 0;
+      for (size_t i = 0; i < n; ++i) {
+        carry += static_cast<uint64_t>(a[i]) * m;
+        limb_t lo = static_cast<limb_t>(carry);
+        carry >>= 32u;
+        carry += lo > r[i] ? 1 : 0;
+        expected[i] = r[i] - lo;
+      }
+      res = r;
+      EXPECT_EQ(carry, limb_kernels::submul_1(res.data(), a.data(), n, m));
+      EXPECT_EQ(expected, res);
+    }
+  }
+}
+
+namespace {
+// сверяет два набора ядер на всех длинах до max_n, в том числе на месте любого из операндов.
+// Длинные серии из нулей и единиц протаскивают перенос (заём) через всё число до старшего лимба
+void expect_same_arith(limb_kernels::arith_table const &x, limb_kernels::arith_table const &y, size_t max_n) {
+  using limb_t = limb_kernels::limb_t;
+  std::default_random_engine rng(46);
+  auto fill = [&](std::vector<limb_t> &v, int pattern) {
+    for (limb_t &d : v) {
+      d = pattern == 0 ? UINT32_MAX : pattern == 1 ? 0 : static_cast<limb_t>(rng());
+    }
+  };
+  for (size_t n = 0; n <= max_n; ++n) {
+    for (int itn = 0; itn < 27; ++itn) {
+      std::vector<limb_t> a(n), b(n), r(n);
+      fill(a, itn % 3);
+      fill(b, itn / 3 % 3);
+      fill(r, itn / 9 % 3);
+      if (n > 0 && itn % 2 == 0) {
+        b[0] = static_cast<limb_t>(rng());
+      }
+      limb_t m = itn % 4 == 0 ? UINT32_MAX : static_cast<limb_t>(rng());
+
+      for (auto fn : {&limb_kernels::arith_table::add_n, &limb_kernels::arith_table::sub_n}) {
+        std::vector<limb_t> rx(n), ry(n);
+        ASSERT_EQ((y.*fn)(ry.data(), a.data(), b.data(), n), (x.*fn)(rx.data(), a.data(), b.data(), n)) << n;
+        ASSERT_EQ(ry, rx) << n;
+        rx = a;
+        ry = a;
+        ASSERT_EQ((y.*fn)(ry.data(), ry.data(), b.data(), n), (x.*fn)(rx.data(), rx.data(), b.data(), n)) << n;
+        ASSERT_EQ(ry, rx) << n;
+        rx = b;
+        ry = b;
+        ASSERT_EQ((y.*fn)(ry.data(), a.data(), ry.data(), n), (x.*fn)(rx.data(), a.data(), rx.data(), n)) << n;
+        ASSERT_EQ(ry, rx) << n;
+        // лимбы со сдвигом на один: словами из двух лимбов они читаются невыровненными
+        std::vector<limb_t> a1(n + 1), b1(n + 1), rx1(n + 1), ry1(n + 1);
+        std::copy(a.begin(), a.end(), a1.begin() + 1);
+        std::copy(b.begin(), b.end(), b1.begin() + 1);
+        ASSERT_EQ((y.*fn)(ry1.data() + 1, a1.data() + 1, b1.data() + 1, n),
+                  (x.*fn)(rx1.data() + 1, a1.data() + 1, b1.data() + 1, n)) << n;
+        ASSERT_EQ(ry1, rx1) << n;
+      }
+
+      for (auto fn : {&limb_kernels::arith_table::mul_1, &limb_kernels::arith_table::addmul_1,
+                      &limb_kernels::arith_table::submul_1}) {
+        std::vector<limb_t> rx = r, ry = r;
+        ASSERT_EQ((y.*fn)(ry.data(), a.data(), n, m), (x.*fn)(rx.data(), a.data(), n, m)) << n;
+        ASSERT_EQ(ry, rx) << n;
+      }
+      std::vector<limb_t> rx = a, ry = a;
+      ASSERT_EQ(y.mul_1(ry.data(), ry.data(), n, m), x.mul_1(rx.data(), rx.data(), n, m)) << n;
+      ASSERT_EQ(ry, rx) << n;
+      uint64_t m2 = itn % 4 == 0 ? UINT64_MAX : (static_cast<uint64_t>(rng()) << 32u) | m;
+      rx = r;
+      ry = r;
+      ASSERT_EQ(y.addmul_2(ry.data(), a.data(), n, m2), x.addmul_2(rx.data(), a.data(), n, m2)) << n;
+      ASSERT_EQ(ry, rx) << n;
+    }
+  }
+}
+}
+
+TEST(kernels, adx_matches_generic) {
+  if (!limb_kernels::available(limb_kernels::arith_tier::adx)) {
+    return;
+  }
+  expect_same_arith(limb_kernels::table(limb_kernels::arith_tier::generic),
+                    limb_kernels::table(limb_kernels::arith_tier::adx), 64);
+}
+
+TEST(kernels, longarith_matches_generic) {
+  if (!limb_kernels::available(limb_kernels::arith_tier::longarith)) {
+    return;
+  }
+  expect_same_arith(limb_kernels::table(limb_kernels::arith_tier::generic),
+                    limb_kernels::table(limb_kernels::arith_tier::longarith), 64);
+}
+
+TEST(mul, basecase_shapes) {
+  std::default_random_engine rng(42);
+  for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+    big_integer_gmp x, y;
+    x.random(1 + itn % 40, rng);
+    y.random(max_size / 4, rng);
+    big_integer a(to_string(x)), b(to_string(y));
+    std::string expected = to_string(x * y);
+    EXPECT_EQ(expected, to_string(a * b));
+    EXPECT_EQ(expected, to_string(b * a));
+    big_integer c = a;
+    EXPECT_EQ(expected, to_string(c.naive_mul(b)));
+    big_integer r = 12345;
+    mul(r, b, a);
+    EXPECT_EQ(expected, to_string(r));
+  }
+}
+
+TEST(capacity, retained_until_released) {
+  big_integer a;
+  a.reserve(100);
+  size_t cap = a.capacity();
+  EXPECT_GE(cap, 100u);
+  big_integer one = big_integer(1) << 1000;
+  for (int i = 0; i < 10; ++i) {
+    a += one;
+    a -= one;
+    a += one;
+    a <<= 64;
+    a >>= 64;
+    a -= one;
+  }
+  EXPECT_EQ(0, a);
+  EXPECT_EQ(cap, a.capacity());
+
+  a = one;
+  a >>= 990;
+  EXPECT_EQ(1024, a);
+  EXPECT_EQ(cap, a.capacity());
+  a.shrink_to_fit();
+  EXPECT_EQ(1024, a);
+  a = -5;
+  EXPECT_EQ(-5, a);
+  cap = a.capacity();
+  a = 0;
+  EXPECT_EQ(cap, a.capacity());
+  a.shrink_to_fit();
+  EXPECT_EQ(0, a);
+}
+
+// после операций сверху могут остаться лишние знаковые лимбы; снаружи их не видно
+TEST(capacity, redundant_limbs_are_invisible) {
+  big_integer a = big_integer(UINT64_MAX);
+  a += 1;
+  a -= 1;
+  EXPECT_EQ(2u, a.size());
+  EXPECT_EQ(64u, a.bit_length());
+  EXPECT_EQ(big_integer(UINT64_MAX), a);
+  EXPECT_EQ("18446744073709551615", to_string(a));
+  EXPECT_EQ(big_integer(UINT64_MAX), a & big_integer(-1));
+  EXPECT_EQ(-big_integer(UINT64_MAX) - 1, ~a);
+
+  big_integer b = -(big_integer(1) << 64);
+  b += big_integer(1) << 64;
+  EXPECT_EQ(0u, b.size());
+  EXPECT_EQ(0, b);
+  EXPECT_EQ("0", to_string(b));
+  EXPECT_EQ(-1, ~b);
+  EXPECT_EQ(0, -b);
+  EXPECT_EQ(SIZE_MAX, b.countr_zero());
+
+  std::mt19937 rng(49);
+  big_integer x = 1;
+  big_integer y("-98765432109876543210987654321");
+  for (int i = 0; i < 2000; ++i) {
+    switch (rng() % 6) {
+      case 0: x += y; break;
+      case 1: x -= y; break;
+      case 2: x <<= static_cast<int>(rng() % 70); break;
+      case 3: x >>= static_cast<int>(rng() % 70); break;
+      case 4: x.negate(); break;
+      default: x *= static_cast<int>(rng() % 7) - 3; x += 1; break;
+    }
+    // то же число, собранное заново, -- в каноническом виде
+    big_integer fresh(to_string(x));
+    ASSERT_EQ(fresh.size(), x.size());
+    ASSERT_EQ(fresh.bit_length(), x.bit_length());
+    ASSERT_EQ(fresh.popcount(), x.popcount());
+    ASSERT_EQ(fresh.countr_zero(), x.countr_zero());
+    ASSERT_EQ(0, fresh.compare_to(x));
+    ASSERT_EQ(fresh & y, x & y);
+    ASSERT_EQ(fresh ^ y, x ^ y);
+    ASSERT_EQ(fresh * y, x * y);
+    ASSERT_EQ(fresh % y, x % y);
+  }
+}
+
+TEST(compact, matches_big_integer) {
+  EXPECT_EQ(16u, sizeof(compact_integer));
+  std::mt19937_64 rng(50);
+  std::vector<int64_t> pool = {0, 1, -1, 2, -2, 3, INT64_MAX, INT64_MIN, INT64_MAX - 1, INT64_MIN + 1,
+                               INT32_MAX, INT32_MIN, int64_t(1) << 32, -(int64_t(1) << 32)};
+  for (int i = 0; i < 20; ++i) {
+    pool.push_back(static_cast<int64_t>(rng()));
+    pool.push_back(static_cast<int64_t>(rng()) >> (rng() % 64));
+  }
+  std::vector<compact_integer> values;
+  for (int64_t x : pool) {
+    values.emplace_back(x);
+  }
+  // несколько чисел вне int64_t
+  values.emplace_back(big_integer(1) << 63);
+  values.emplace_back(-(big_integer(1) << 63) - 1);
+  values.emplace_back(big_integer("123456789012345678901234567890"));
+  values.emplace_back(big_integer("-98765432109876543210987654321"));
+  for (compact_integer const &a : values) {
+    big_integer ba = a.to_big_integer();
+    EXPECT_EQ(to_string(ba), to_string(a));
+    EXPECT_EQ(to_string(-ba), to_string(-a));
+    for (compact_integer const &b : values) {
+      big_integer bb = b.to_big_integer();
+      EXPECT_EQ(ba + bb, (a + b).to_big_integer());
+      EXPECT_EQ(ba - bb, (a - b).to_big_integer());
+      EXPECT_EQ(ba * bb, (a * b).to_big_integer());
+      if (bb != 0) {
+        EXPECT_EQ(ba / bb, (a / b).to_big_integer());
+        EXPECT_EQ(ba % bb, (a % b).to_big_integer());
+      }
+      EXPECT_EQ(ba.compare_to(bb) < 0, a < b);
+      EXPECT_EQ(ba == bb, a == b);
+      // результат в пределах int64_t всегда хранится без кучи
+      compact_integer sum = a + b;
+      EXPECT_EQ(compact_integer(sum.to_big_integer()).is_small(), sum.is_small());
+    }
+  }
+}
+
+TEST(compact, promotion_and_demotion) {
+  compact_integer a = INT64_MAX;
+  EXPECT_TRUE(a.is_small());
+  a += 1;
+  EXPECT_FALSE(a.is_small());
+  EXPECT_EQ(big_integer(uint64_t(1) << 63), a.to_big_integer());
+  a -= 1;
+  EXPECT_TRUE(a.is_small());
+  EXPECT_EQ(INT64_MAX, a.small_value());
+
+  compact_integer m = INT64_MIN;
+  compact_integer q = m / compact_integer(-1);
+  EXPECT_FALSE(q.is_small());
+  EXPECT_EQ(compact_integer(0), m % compact_integer(-1));
+  EXPECT_TRUE((-q).is_small());
+  EXPECT_EQ(INT64_MIN, (-q).small_value());
+  EXPECT_FALSE(compact_integer(UINT64_MAX).is_small());
+  EXPECT_EQ("18446744073709551615", to_string(compact_integer(UINT64_MAX)));
+
+  compact_integer s = INT64_MAX;
+  s += s;
+  EXPECT_EQ(big_integer(uint64_t(INT64_MAX)) * 2, s.to_big_integer());
+  s *= s;
+  s = s / s;
+  EXPECT_TRUE(s.is_small());
+  EXPECT_EQ(1, s.small_value());
+
+  compact_integer copy = q;
+  compact_integer moved = std::move(copy);
+  EXPECT_TRUE(copy.is_small());
+  EXPECT_EQ(q, moved);
+  copy = moved;
+  EXPECT_EQ(q, copy);
+  copy = 5;
+  EXPECT_TRUE(copy.is_small());
+  EXPECT_THROW(copy /= compact_integer(0), std::runtime_error);
+  EXPECT_EQ(5, copy.small_value());
+}
@@ -0,0 +1,81 @@
+#include "chunk_stack.h"
+
+#include <algorithm>
+#include <new>
+
+struct chunk_stack::chunk {
+	chunk *next;
+	size_t size;
+	size_t used;
+
+	char *data() {
+		return reinterpret_cast<char *>(this) + header_size();
+	}
+
+	static size_t header_size() {
+		return (sizeof(chunk) + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+	}
+};
+
+void *chunk_stack::allocate(size_t bytes, size_t min_chunk_size) {
+	bytes = (bytes + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+	while (current == nullptr || current->used + bytes > current->size) {
+		chunk *next = current == nullptr ? head : current->next;
+		if (next != nullptr && next->size >= bytes) {
+			current = next;
+			current->used = 0;
+			continue;
+		}
+		// слишком маленький запасной чанк не выбрасываем, а оставляем следующим за новым
+		size_t size = std::max(bytes, current == nullptr ? min_chunk_size : 2 * current->size);
+		auto *c = static_cast<chunk *>(::operator new(chunk::header_size() + size));
+		c->next = next;
+		c->size = size;
+		c->used = 0;
+		if (current == nullptr) {
+			head = c;
+		} else {
+			current->next = c;
+		}
+		current = c;
+		reserved_bytes += size;
+	}
+	void *result = current->data() + current->used;
+	current->used += bytes;
+	return result;
+}
+
+chunk_stack::mark chunk_stack::get_mark() const {
+	return {current, current == nullptr ? 0 : current->used};
+}
+
+void chunk_stack::rollback(mark m) {
+	current = m.at;
+	if (current != nullptr) {
+		current->used = m.used;
+	}
+}
+
+bool chunk_stack::owns(void const *p) const {
+	char const *ptr = static_cast<char const *>(p);
+	for (chunk *c = head; c != nullptr; c = c->next) {
+		if (ptr >= c->data() && ptr < c->data() + c->size) {
+			return true;
+		}
+	}
+	return false;
+}
+
+size_t chunk_stack::reserved() const {
+	return reserved_bytes;
+}
+
+void chunk_stack::release() {
+	while (head != nullptr) {
+		chunk *c = head;
+		head = c->next;
+		::operator delete(c);
+	}
+	current = nullptr;
+	reserved_bytes = 0;
+}
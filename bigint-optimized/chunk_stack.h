@@ -0,0 +1,33 @@
+#ifndef CHUNK_STACK_H
+#define CHUNK_STACK_H
+
+#include <cstddef>
+
+// Стек чанков памяти: выделение сдвигом указателя, освобождение откатом к отметке.
+// Чанки после отката не отдаются куче, а переиспользуются. Общая основа limb_arena и scratch_space.
+struct chunk_stack {
+	static size_t constexpr ALIGNMENT = 16;
+
+	struct chunk;
+	struct mark {
+		chunk *at;
+		size_t used;
+	};
+
+	constexpr chunk_stack()
+		: head(nullptr), current(nullptr), reserved_bytes(0) {}
+
+	void *allocate(size_t bytes, size_t min_chunk_size);
+	mark get_mark() const;
+	void rollback(mark m);
+	bool owns(void const *p) const;
+	size_t reserved() const;
+	void release();
+
+  private:
+	chunk *head;
+	chunk *current;  // всё до current включительно занято, всё после -- запас
+	size_t reserved_bytes;
+};
+
+#endif //CHUNK_STACK_H
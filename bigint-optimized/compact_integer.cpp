@@ -0,0 +1,187 @@
+#include "compact_integer.h"
+
+#include <stdexcept>
+
+// a помещается в int64_t <=> не больше двух лимбов и старший бит 64-битного слова совпадает со знаком
+bool compact_integer::fits_small(big_integer const &a, int64_t &out) {
+	if (a.size() > 2) {
+		return false;
+	}
+	uint64_t bits = static_cast<uint64_t>(a.get(1)) << 32u | a.get(0);
+	out = static_cast<int64_t>(bits);
+	return (out < 0) == a.inf_1_after_last_digit;
+}
+
+compact_integer::compact_integer() : small(0), heap(false) {}
+
+compact_integer::compact_integer(big_integer const &a) : heap(false) {
+	if (!fits_small(a, small)) {
+		big = new big_integer(a, heap_allocator());
+		heap = true;
+	}
+}
+
+compact_integer::compact_integer(big_integer &&a) : heap(false) {
+	if (!fits_small(a, small)) {
+		// перемещение в число с другим аллокатором копирует лимбы
+		big = new big_integer(heap_allocator());
+		*big = std::move(a);
+		heap = true;
+	}
+}
+
+compact_integer::compact_integer(compact_integer const &other) : heap(other.heap) {
+	if (heap) {
+		big = new big_integer(*other.big, heap_allocator());
+	} else {
+		small = other.small;
+	}
+}
+
+compact_integer::compact_integer(compact_integer &&other) noexcept : heap(other.heap) {
+	if (heap) {
+		big = other.big;
+	} else {
+		small = other.small;
+	}
+	other.small = 0;
+	other.heap = false;
+}
+
+compact_integer::~compact_integer() {
+	release();
+}
+
+// число в куче копируется в уже выделенный big_integer, если он есть
+compact_integer &compact_integer::operator=(compact_integer const &rhs) {
+	if (this == &rhs) {
+		return *this;
+	}
+	if (!rhs.heap) {
+		release();
+		small = rhs.small;
+	} else if (heap) {
+		*big = *rhs.big;
+	} else {
+		big = new big_integer(*rhs.big, heap_allocator());
+		heap = true;
+	}
+	return *this;
+}
+
+compact_integer &compact_integer::operator=(compact_integer &&rhs) noexcept {
+	if (this == &rhs) {
+		return *this;
+	}
+	release();
+	heap = rhs.heap;
+	if (heap) {
+		big = rhs.big;
+	} else {
+		small = rhs.small;
+	}
+	rhs.small = 0;
+	rhs.heap = false;
+	return *this;
+}
+
+big_integer compact_integer::to_big_integer() const {
+	if (heap) {
+		return *big;
+	}
+	big_integer res;
+	res = small;
+	return res;
+}
+
+compact_integer compact_integer::operator+() const {
+	return *this;
+}
+
+// -INT64_MIN уже не помещается в int64_t
+compact_integer compact_integer::operator-() const {
+	if (!heap && small != INT64_MIN) {
+		return -small;
+	}
+	compact_integer res(*this);
+	res.promote().negate();
+	res.demote();
+	return res;
+}
+
+big_integer &compact_integer::promote() {
+	if (!heap) {
+		int64_t x = small;
+		big = new big_integer(heap_allocator());
+		heap = true;
+		*big = x;
+	}
+	return *big;
+}
+
+void compact_integer::demote() {
+	int64_t x;
+	if (heap && fits_small(*big, x)) {
+		delete big;
+		small = x;
+		heap = false;
+	}
+}
+
+void compact_integer::release() {
+	if (heap) {
+		delete big;
+		small = 0;
+		heap = false;
+	}
+}
+
+// rhs может совпадать с *this: после promote он тоже в куче, и big_integer сам разбирается с a += a
+compact_integer &compact_integer::add_slow(compact_integer const &rhs, bool subtract) {
+	big_integer &a = promote();
+	if (rhs.heap && subtract) {
+		a -= *rhs.big;
+	} else if (rhs.heap) {
+		a += *rhs.big;
+	} else if (subtract) {
+		a -= rhs.small;
+	} else {
+		a += rhs.small;
+	}
+	demote();
+	return *this;
+}
+
+compact_integer &compact_integer::mul_slow(compact_integer const &rhs) {
+	big_integer &a = promote();
+	if (rhs.heap) {
+		a *= *rhs.big;
+	} else {
+		a *= rhs.small;
+	}
+	demote();
+	return *this;
+}
+
+// ноль проверяется до promote, чтобы исключение не оставило малое число в куче
+compact_integer &compact_integer::div_slow(compact_integer const &rhs, bool remainder) {
+	if (!rhs.heap && rhs.small == 0) {
+		throw std::runtime_error("division by zero");
+	}
+	big_integer &a = promote();
+	if (rhs.heap && remainder) {
+		a %= *rhs.big;
+	} else if (rhs.heap) {
+		a /= *rhs.big;
+	} else if (remainder) {
+		a %= rhs.small;
+	} else {
+		a /= rhs.small;
+	}
+	demote();
+	return *this;
+}
+
+std::string to_string(compact_integer const &a) {
+	return a.heap ? to_string(*a.big) : std::to_string(a.small);
+}
@@ -0,0 +1,192 @@
+#ifndef COMPACT_INTEGER_H
+#define COMPACT_INTEGER_H
+
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+#include "big_integer.h"
+
+// Длинное число в 16 байтах для больших таблиц, где почти все значения маленькие.
+// Число, которое помещается в int64_t, хранится прямо в дескрипторе и памяти не занимает;
+// остальные -- в big_integer в куче, на который дескриптор указывает.
+// Форма однозначна: в куче только числа вне int64_t, поэтому результат, вернувшийся в 64 бита,
+// сразу становится малым. Если оба операнда малые, операции обходятся встроенной арифметикой
+// с проверкой переполнения и переходят на big_integer, только когда она переполнилась.
+// Числа в куче всегда живут в limb_pool: дескриптор может быть создан вне limb_arena::scope,
+// а стать большим внутри него.
+struct compact_integer {
+	compact_integer();
+	template <typename T, typename = big_integer_native_t<T>>
+	compact_integer(T a);
+	compact_integer(big_integer const &a);
+	compact_integer(big_integer &&a);
+	compact_integer(compact_integer const &other);
+	compact_integer(compact_integer &&other) noexcept;
+	~compact_integer();
+
+	compact_integer &operator=(compact_integer const &rhs);
+	compact_integer &operator=(compact_integer &&rhs) noexcept;
+
+	// small_value() -- только для малых чисел
+	bool is_small() const;
+	int64_t small_value() const;
+	big_integer to_big_integer() const;
+
+	compact_integer &operator+=(compact_integer const &rhs);
+	compact_integer &operator-=(compact_integer const &rhs);
+	compact_integer &operator*=(compact_integer const &rhs);
+	// деление с округлением к нулю, остаток берёт знак делимого -- как у big_integer
+	compact_integer &operator/=(compact_integer const &rhs);
+	compact_integer &operator%=(compact_integer const &rhs);
+
+	compact_integer operator+() const;
+	compact_integer operator-() const;
+
+	int compare_to(compact_integer const &other) const;
+
+	friend std::string to_string(compact_integer const &a);
+
+  private:
+	union {
+		int64_t small;
+		big_integer *big;
+	};
+	bool heap;
+
+	static big_integer::allocator_type heap_allocator();
+	static bool fits_small(big_integer const &a, int64_t &out);
+	big_integer &promote();
+	void demote();
+	void release();
+	compact_integer &add_slow(compact_integer const &rhs, bool subtract);
+	compact_integer &mul_slow(compact_integer const &rhs);
+	compact_integer &div_slow(compact_integer const &rhs, bool remainder);
+};
+
+// беззнаковые больше INT64_MAX сразу идут в кучу
+template <typename T, typename>
+compact_integer::compact_integer(T a) : heap(false) {
+	if (std::is_unsigned<T>::value && static_cast<uint64_t>(a) > static_cast<uint64_t>(INT64_MAX)) {
+		big = new big_integer(static_cast<uint64_t>(a), heap_allocator());
+		heap = true;
+	} else {
+		small = static_cast<int64_t>(a);
+	}
+}
+
+inline big_integer::allocator_type compact_integer::heap_allocator() {
+	return big_integer::allocator_type(limb_pool::resource());
+}
+
+inline bool compact_integer::is_small() const {
+	return !heap;
+}
+
+inline int64_t compact_integer::small_value() const {
+	return small;
+}
+
+inline compact_integer &compact_integer::operator+=(compact_integer const &rhs) {
+	int64_t r;
+	if (!heap && !rhs.heap && !__builtin_add_overflow(small, rhs.small, &r)) {
+		small = r;
+		return *this;
+	}
+	return add_slow(rhs, false);
+}
+
+inline compact_integer &compact_integer::operator-=(compact_integer const &rhs) {
+	int64_t r;
+	if (!heap && !rhs.heap && !__builtin_sub_overflow(small, rhs.small, &r)) {
+		small = r;
+		return *this;
+	}
+	return add_slow(rhs, true);
+}
+
+inline compact_integer &compact_integer::operator*=(compact_integer const &rhs) {
+	int64_t r;
+	if (!heap && !rhs.heap && !__builtin_mul_overflow(small, rhs.small, &r)) {
+		small = r;
+		return *this;
+	}
+	return mul_slow(rhs);
+}
+
+// INT64_MIN / -1 не помещается в int64_t и уходит в медленный путь вместе с делением на ноль
+inline compact_integer &compact_integer::operator/=(compact_integer const &rhs) {
+	if (!heap && !rhs.heap && rhs.small != 0 && rhs.small != -1) {
+		small /= rhs.small;
+		return *this;
+	}
+	return div_slow(rhs, false);
+}
+
+inline compact_integer &compact_integer::operator%=(compact_integer const &rhs) {
+	if (!heap && !rhs.heap && rhs.small != 0 && rhs.small != -1) {
+		small %= rhs.small;
+		return *this;
+	}
+	return div_slow(rhs, true);
+}
+
+inline int compact_integer::compare_to(compact_integer const &other) const {
+	if (!heap && !other.heap) {
+		return small < other.small ? -1 : small > other.small ? 1 : 0;
+	}
+	if (heap && other.heap) {
+		return big->compare_to(*other.big);
+	}
+	// число в куче по модулю больше любого малого, так что решает его знак
+	bool negative = heap ? big->inf_1_after_last_digit : !other.big->inf_1_after_last_digit;
+	return negative ? -1 : 1;
+}
+
+inline compact_integer operator+(compact_integer a, compact_integer const &b) {
+	return a += b;
+}
+
+inline compact_integer operator-(compact_integer a, compact_integer const &b) {
+	return a -= b;
+}
+
+inline compact_integer operator*(compact_integer a, compact_integer const &b) {
+	return a *= b;
+}
+
+inline compact_integer operator/(compact_integer a, compact_integer const &b) {
+	return a /= b;
+}
+
+inline compact_integer operator%(compact_integer a, compact_integer const &b) {
+	return a %= b;
+}
+
+inline bool operator==(compact_integer const &a, compact_integer const &b) {
+	return a.compare_to(b) == 0;
+}
+
+inline bool operator!=(compact_integer const &a, compact_integer const &b) {
+	return a.compare_to(b) != 0;
+}
+
+inline bool operator<(compact_integer const &a, compact_integer const &b) {
+	return a.compare_to(b) < 0;
+}
+
+inline bool operator>(compact_integer const &a, compact_integer const &b) {
+	return a.compare_to(b) > 0;
+}
+
+inline bool operator<=(compact_integer const &a, compact_integer const &b) {
+	return a.compare_to(b) <= 0;
+}
+
+inline bool operator>=(compact_integer const &a, compact_integer const &b) {
+	return a.compare_to(b) >= 0;
+}
+
+std::string to_string(compact_integer const &a);
+
+#endif //COMPACT_INTEGER_H
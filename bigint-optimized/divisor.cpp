@@ -0,0 +1,31 @@
+#include "divisor.h"
+#include "limb_kernels.h"
+
+#include <stdexcept>
+
+divisor::divisor(uint64_t d)
+	: d(d), normalized(0), shift(0), v(0) {
+	if (d == 0) {
+		throw std::runtime_error("division by zero");
+	}
+	if (d >> 32u == 0) {
+		shift = __builtin_clz(static_cast<uint32_t>(d));
+		normalized = d << shift;
+		v = limb_kernels::invert_limb(static_cast<uint32_t>(normalized));
+	} else {
+		shift = __builtin_clzll(d);
+		normalized = d << shift;
+		v = limb_kernels::invert_pair(normalized);
+	}
+}
+
+uint64_t divisor::get() const {
+	return d;
+}
+
+uint64_t divisor::divrem(uint32_t *q, uint32_t const *a, size_t n) const {
+	if (d >> 32u == 0) {
+		return limb_kernels::divrem_1_preinv(q, a, n, static_cast<uint32_t>(normalized), shift, v);
+	}
+	return limb_kernels::divrem_2_preinv(q, a, n, normalized, shift, v);
+}
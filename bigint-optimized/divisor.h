@@ -0,0 +1,24 @@
+#ifndef DIVISOR_H
+#define DIVISOR_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Делитель из одного или двух лимбов (1 <= d < 2^64) с заранее посчитанными нормализацией и обратной величиной.
+// Создаётся один раз и переиспользуется: a / d, a % d и divmod(q, r, a, d) для big_integer
+// тогда обходятся умножениями вместо инструкции div на каждый лимб.
+struct divisor {
+	explicit divisor(uint64_t d);
+
+	uint64_t get() const;
+	// q[0..n) = a[0..n) / d, возвращает остаток; q может совпадать с a
+	uint64_t divrem(uint32_t *q, uint32_t const *a, size_t n) const;
+
+  private:
+	uint64_t d;
+	uint64_t normalized;
+	unsigned shift;
+	uint32_t v;
+};
+
+#endif //DIVISOR_H
@@ -0,0 +1,99 @@
+#include "limb_arena.h"
+#include "limb_pool.h"
+
+#include <cassert>
+#include <new>
+
+namespace {
+
+struct arena_state {
+	chunk_stack chunks;
+	size_t depth;
+	limb_arena::scope *innermost;
+	bool registered;
+};
+
+struct arena_guard {
+	~arena_guard();
+};
+
+thread_local arena_state state = {chunk_stack(), 0, nullptr, false};
+thread_local arena_guard guard;
+
+arena_state &local_state() {
+	if (!state.registered) {
+		state.registered = true;
+		static_cast<void>(&guard);
+	}
+	return state;
+}
+
+arena_guard::~arena_guard() {
+	limb_arena::release();
+}
+
+}
+
+limb_arena::scope::scope() {
+	arena_state &s = local_state();
+	saved = s.chunks.get_mark();
+	resource.depth = ++s.depth;
+	parent = s.innermost;
+	s.innermost = this;
+}
+
+limb_arena::scope::~scope() {
+	state.chunks.rollback(saved);
+	state.depth--;
+	state.innermost = parent;
+}
+
+void *limb_arena::scope::level_resource::do_allocate(size_t bytes, size_t alignment) {
+	if (alignment > chunk_stack::ALIGNMENT) {
+		throw std::bad_alloc();
+	}
+	if (state.depth != depth) {
+		return limb_pool::allocate(bytes);
+	}
+	return state.chunks.allocate(bytes, MIN_CHUNK_SIZE);
+}
+
+void limb_arena::scope::level_resource::do_deallocate(void *p, size_t bytes, size_t) {
+	if (!owns(p)) {
+		limb_pool::deallocate(p, bytes);
+	}
+}
+
+bool limb_arena::scope::level_resource::do_is_equal(std::pmr::memory_resource const &other) const noexcept {
+	return this == &other;
+}
+
+bool limb_arena::active() {
+	return state.depth > 0;
+}
+
+std::pmr::memory_resource *limb_arena::resource() {
+	return state.innermost == nullptr ? nullptr : &state.innermost->resource;
+}
+
+bool limb_arena::is_scope_resource(std::pmr::memory_resource const *r) {
+	for (scope *s = state.innermost; s != nullptr; s = s->parent) {
+		if (r == &s->resource) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool limb_arena::owns(void const *p) {
+	return state.chunks.owns(p);
+}
+
+size_t limb_arena::bytes_reserved() {
+	return state.chunks.reserved();
+}
+
+void limb_arena::release() {
+	assert(state.depth == 0);
+	state.chunks.release();
+}
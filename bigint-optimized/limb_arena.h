@@ -0,0 +1,57 @@
+#ifndef LIMB_ARENA_H
+#define LIMB_ARENA_H
+
+#include <cstddef>
+#include <memory_resource>
+
+#include "chunk_stack.h"
+
+// Монотонная арена потока. Числа, созданные внутри limb_arena::scope, получают ресурс этого scope
+// и выделяют буферы лимбов сдвигом указателя в арене, а освобождение внутри арены ничего не делает.
+// Деструктор scope откатывает арену к состоянию на момент его создания, память остаётся
+// за потоком и переиспользуется следующими scope.
+// Числа, созданные внутри scope, не должны его пережить. Числа, созданные раньше, свой ресурс
+// сохраняют: они растут в limb_pool, а присваивание им (в том числе перемещением) копирует лимбы из арены.
+struct limb_arena {
+	static size_t constexpr MIN_CHUNK_SIZE = static_cast<size_t>(64) << 10u;
+
+	struct scope {
+		scope();
+		~scope();
+		scope(scope const &) = delete;
+		scope &operator=(scope const &) = delete;
+
+	  private:
+		// пока scope самый внутренний, буферы берутся из арены; во вложенном scope -- из limb_pool,
+		// иначе откат вложенного scope забрал бы память у чисел внешнего
+		struct level_resource : std::pmr::memory_resource {
+			size_t depth;
+
+		  private:
+			void *do_allocate(size_t bytes, size_t alignment) override;
+			void do_deallocate(void *p, size_t bytes, size_t alignment) override;
+			bool do_is_equal(std::pmr::memory_resource const &other) const noexcept override;
+		};
+
+		chunk_stack::mark saved;
+		level_resource resource;
+		scope *parent;
+
+		friend struct limb_arena;
+	};
+
+	static bool active();
+	// ресурс самого внутреннего scope; nullptr вне scope
+	static std::pmr::memory_resource *resource();
+	// r принадлежит одному из открытых scope потока
+	static bool is_scope_resource(std::pmr::memory_resource const *r);
+	// p лежит в памяти арены, даже если все scope уже закрыты
+	static bool owns(void const *p);
+
+	// сколько байт арена держит у себя в этом потоке
+	static size_t bytes_reserved();
+	// отдаёт куче всю память арены; вызывать только вне scope
+	static void release();
+};
+
+#endif //LIMB_ARENA_H
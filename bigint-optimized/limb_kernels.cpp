@@ -0,0 +1,404 @@
+#include "limb_kernels.h"
+#include "limb_kernels_adx.h"
+#ifdef BIG_INTEGER_ASM_KERNELS
+#include "limb_kernels_asm.h"
+#endif
+
+#include <algorithm>
+#include <initializer_list>
+
+using limb_t = limb_kernels::limb_t;
+
+namespace {
+
+// переносимые версии; на x86-64 с ADX и BMI2 их заменяют версии из limb_kernels_adx.cpp,
+// а без ADX -- ассемблерные циклы longarith, если они собраны
+limb_t add_n_generic(limb_t *r, limb_t const *a, limb_t const *b, size_t n) {
+	uint64_t carry = 0;
+	for (size_t i = 0; i < n; ++i) {
+		carry += static_cast<uint64_t>(a[i]) + b[i];
+		r[i] = static_cast<limb_t>(carry);
+		carry >>= 32u;
+	}
+	return static_cast<limb_t>(carry);
+}
+
+limb_t sub_n_generic(limb_t *r, limb_t const *a, limb_t const *b, size_t n) {
+	uint64_t borrow = 0;
+	for (size_t i = 0; i < n; ++i) {
+		uint64_t t = static_cast<uint64_t>(a[i]) - b[i] - borrow;
+		r[i] = static_cast<limb_t>(t);
+		borrow = (t >> 32u) & 1u;
+	}
+	return static_cast<limb_t>(borrow);
+}
+
+}
+
+limb_t limb_kernels::add_1(limb_t *r, limb_t const *a, size_t n, limb_t b) {
+	size_t i = 0;
+	for (; i < n && b != 0; ++i) {
+		limb_t t = a[i] + b;
+		b = t < b ? 1 : 0;
+		r[i] = t;
+	}
+	if (r != a) {
+		for (; i < n; ++i) {
+			r[i] = a[i];
+		}
+	}
+	return b;
+}
+
+limb_t limb_kernels::sub_1(limb_t *r, limb_t const *a, size_t n, limb_t b) {
+	size_t i = 0;
+	for (; i < n && b != 0; ++i) {
+		limb_t t = a[i] - b;
+		b = t > a[i] ? 1 : 0;
+		r[i] = t;
+	}
+	if (r != a) {
+		for (; i < n; ++i) {
+			r[i] = a[i];
+		}
+	}
+	return b;
+}
+
+namespace {
+
+// циклы умножения развёрнуты на четыре лимба: умножения соседних лимбов не зависят друг от друга,
+// и процессор успевает начать следующее, пока перенос идёт по цепочке
+limb_t mul_1_generic(limb_t *r, limb_t const *a, size_t n, limb_t b) {
+	uint64_t carry = 0;
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		uint64_t p0 = static_cast<uint64_t>(a[i]) * b;
+		uint64_t p1 = static_cast<uint64_t>(a[i + 1]) * b;
+		uint64_t p2 = static_cast<uint64_t>(a[i + 2]) * b;
+		uint64_t p3 = static_cast<uint64_t>(a[i + 3]) * b;
+		carry += p0;
+		r[i] = static_cast<limb_t>(carry);
+		carry = (carry >> 32u) + p1;
+		r[i + 1] = static_cast<limb_t>(carry);
+		carry = (carry >> 32u) + p2;
+		r[i + 2] = static_cast<limb_t>(carry);
+		carry = (carry >> 32u) + p3;
+		r[i + 3] = static_cast<limb_t>(carry);
+		carry >>= 32u;
+	}
+	for (; i < n; ++i) {
+		carry += static_cast<uint64_t>(a[i]) * b;
+		r[i] = static_cast<limb_t>(carry);
+		carry >>= 32u;
+	}
+	return static_cast<limb_t>(carry);
+}
+
+limb_t addmul_1_generic(limb_t *r, limb_t const *a, size_t n, limb_t b) {
+	// r[i] + a[i] * b + carry < 2^64, поэтому хватает одного uint64_t
+	uint64_t carry = 0;
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		uint64_t p0 = static_cast<uint64_t>(a[i]) * b + r[i];
+		uint64_t p1 = static_cast<uint64_t>(a[i + 1]) * b + r[i + 1];
+		uint64_t p2 = static_cast<uint64_t>(a[i + 2]) * b + r[i + 2];
+		uint64_t p3 = static_cast<uint64_t>(a[i + 3]) * b + r[i + 3];
+		carry += p0;
+		r[i] = static_cast<limb_t>(carry);
+		carry = (carry >> 32u) + p1;
+		r[i + 1] = static_cast<limb_t>(carry);
+		carry = (carry >> 32u) + p2;
+		r[i + 2] = static_cast<limb_t>(carry);
+		carry = (carry >> 32u) + p3;
+		r[i + 3] = static_cast<limb_t>(carry);
+		carry >>= 32u;
+	}
+	for (; i < n; ++i) {
+		carry += static_cast<uint64_t>(a[i]) * b + r[i];
+		r[i] = static_cast<limb_t>(carry);
+		carry >>= 32u;
+	}
+	return static_cast<limb_t>(carry);
+}
+
+// a[n - 1] * b1 + c0 + c1 <= (2^32 - 1)^2 + 2 * (2^32 - 1) < 2^64
+uint64_t addmul_2_generic(limb_t *r, limb_t const *a, size_t n, uint64_t b) {
+	if (n == 0) {
+		return 0;
+	}
+	limb_t b1 = static_cast<limb_t>(b >> 32u);
+	limb_t c0 = addmul_1_generic(r, a, n, static_cast<limb_t>(b));
+	limb_t c1 = addmul_1_generic(r + 1, a, n - 1, b1);
+	return static_cast<uint64_t>(a[n - 1]) * b1 + c0 + c1;
+}
+
+limb_t submul_1_generic(limb_t *r, limb_t const *a, size_t n, limb_t b) {
+	uint64_t carry = 0;
+	for (size_t i = 0; i < n; ++i) {
+		carry += static_cast<uint64_t>(a[i]) * b;
+		limb_t lo = static_cast<limb_t>(carry);
+		carry >>= 32u;
+		limb_t t = r[i] - lo;
+		carry += t > r[i] ? 1 : 0;
+		r[i] = t;
+	}
+	return static_cast<limb_t>(carry);
+}
+
+using arith_table = limb_kernels::arith_table;
+using arith_tier = limb_kernels::arith_tier;
+
+// выбирается один раз, при первом обращении
+arith_table pick_table() {
+	for (arith_tier tier : {arith_tier::adx, arith_tier::longarith}) {
+		if (limb_kernels::available(tier)) {
+			return limb_kernels::table(tier);
+		}
+	}
+	return limb_kernels::table(arith_tier::generic);
+}
+
+arith_table const &arith() {
+	static arith_table const table = pick_table();
+	return table;
+}
+
+}
+
+bool limb_kernels::available(arith_tier tier) {
+	if (tier == arith_tier::adx) {
+		return limb_kernels_adx::supported();
+	}
+#ifndef BIG_INTEGER_ASM_KERNELS
+	if (tier == arith_tier::longarith) {
+		return false;
+	}
+#endif
+	return true;
+}
+
+limb_kernels::arith_table limb_kernels::table(arith_tier tier) {
+	if (tier == arith_tier::adx) {
+		return {limb_kernels_adx::add_n, limb_kernels_adx::sub_n, limb_kernels_adx::mul_1,
+			limb_kernels_adx::addmul_1, limb_kernels_adx::addmul_2, limb_kernels_adx::submul_1};
+	}
+#ifdef BIG_INTEGER_ASM_KERNELS
+	if (tier == arith_tier::longarith) {
+		return {limb_kernels_asm::add_n, limb_kernels_asm::sub_n, limb_kernels_asm::mul_1,
+			addmul_1_generic, addmul_2_generic, submul_1_generic};
+	}
+#endif
+	return {add_n_generic, sub_n_generic, mul_1_generic, addmul_1_generic, addmul_2_generic, submul_1_generic};
+}
+
+limb_t limb_kernels::add_n(limb_t *r, limb_t const *a, limb_t const *b, size_t n) {
+	return arith().add_n(r, a, b, n);
+}
+
+limb_t limb_kernels::sub_n(limb_t *r, limb_t const *a, limb_t const *b, size_t n) {
+	return arith().sub_n(r, a, b, n);
+}
+
+limb_t limb_kernels::mul_1(limb_t *r, limb_t const *a, size_t n, limb_t b) {
+	return arith().mul_1(r, a, n, b);
+}
+
+limb_t limb_kernels::addmul_1(limb_t *r, limb_t const *a, size_t n, limb_t b) {
+	return arith().addmul_1(r, a, n, b);
+}
+
+uint64_t limb_kernels::addmul_2(limb_t *r, limb_t const *a, size_t n, uint64_t b) {
+	return arith().addmul_2(r, a, n, b);
+}
+
+limb_t limb_kernels::submul_1(limb_t *r, limb_t const *a, size_t n, limb_t b) {
+	return arith().submul_1(r, a, n, b);
+}
+
+// строки идут по более длинному множителю: меньше вызовов ядра, и каждый вызов длиннее
+void limb_kernels::mul_basecase(limb_t *r, limb_t const *a, size_t n, limb_t const *b, size_t m) {
+	if (n > m) {
+		std::swap(a, b);
+		std::swap(n, m);
+	}
+	if (n == 0) {
+		std::fill(r, r + m, 0);
+		return;
+	}
+	r[m] = mul_1(r, b, m, a[0]);
+	for (size_t i = 1; i < n; ++i) {
+		r[i + m] = addmul_1(r + i, b, m, a[i]);
+	}
+}
+
+limb_t limb_kernels::divrem_1(limb_t *q, limb_t const *a, size_t n, limb_t d) {
+	unsigned shift = __builtin_clz(d);
+	return divrem_1_preinv(q, a, n, d << shift, shift, invert_limb(d << shift));
+}
+
+limb_t limb_kernels::invert_limb(limb_t d) {
+	return static_cast<limb_t>(UINT64_MAX / d - (static_cast<uint64_t>(1) << 32u));
+}
+
+namespace {
+
+// __extension__ -- чтобы -Wpedantic не ругался на нестандартный тип
+__extension__ typedef unsigned __int128 dword_t;
+
+}
+
+limb_t limb_kernels::invert_pair(uint64_t d) {
+	dword_t b3 = (static_cast<dword_t>(1) << 96u) - 1;
+	return static_cast<limb_t>(b3 / d - (static_cast<uint64_t>(1) << 32u));
+}
+
+namespace {
+
+// (u1, u0) / d при u1 < d; q -- частное, u1 -- остаток
+limb_t div_2by1(limb_t &u1, limb_t u0, limb_t d, limb_t v) {
+	uint64_t p = static_cast<uint64_t>(v) * u1 + ((static_cast<uint64_t>(u1) << 32u) | u0);
+	limb_t q = static_cast<limb_t>(p >> 32u) + 1;
+	limb_t r = u0 - q * d;
+	if (r > static_cast<limb_t>(p)) {
+		q--;
+		r += d;
+	}
+	if (r >= d) {
+		q++;
+		r -= d;
+	}
+	u1 = r;
+	return q;
+}
+
+// (r, u0) / d при r < d, где r и d -- пары лимбов; r становится остатком
+limb_t div_3by2(uint64_t &r, limb_t u0, uint64_t d, limb_t v) {
+	limb_t u2 = static_cast<limb_t>(r >> 32u), u1 = static_cast<limb_t>(r);
+	limb_t d1 = static_cast<limb_t>(d >> 32u), d0 = static_cast<limb_t>(d);
+	uint64_t p = static_cast<uint64_t>(v) * u2 + r;
+	limb_t q = static_cast<limb_t>(p >> 32u);
+	limb_t r1 = u1 - q * d1;
+	r = ((static_cast<uint64_t>(r1) << 32u) | u0) - static_cast<uint64_t>(d0) * q - d;
+	q++;
+	if (static_cast<limb_t>(r >> 32u) >= static_cast<limb_t>(p)) {
+		q--;
+		r += d;
+	}
+	if (r >= d) {
+		q++;
+		r -= d;
+	}
+	return q;
+}
+
+// i-й лимб a, сдвинутого на shift бит влево
+limb_t shifted(limb_t const *a, size_t i, unsigned shift) {
+	if (shift == 0) {
+		return a[i];
+	}
+	return (a[i] << shift) | (i > 0 ? a[i - 1] >> (32 - shift) : 0);
+}
+
+}
+
+limb_t limb_kernels::divrem_1_preinv(limb_t *q, limb_t const *a, size_t n, limb_t d, unsigned shift, limb_t v) {
+	if (n == 0) {
+		return 0;
+	}
+	limb_t r = shift == 0 ? 0 : a[n - 1] >> (32 - shift);
+	for (size_t i = n; i > 0; --i) {
+		// a[i - 2] читается раньше, чем q[i - 1] перезапишет a[i - 1], поэтому q может совпадать с a
+		limb_t u0 = shifted(a, i - 1, shift);
+		q[i - 1] = div_2by1(r, u0, d, v);
+	}
+	return r >> shift;
+}
+
+uint64_t limb_kernels::divrem_2_preinv(limb_t *q, limb_t const *a, size_t n, uint64_t d, unsigned shift, limb_t v) {
+	if (n == 0) {
+		return 0;
+	}
+	uint64_t r = shift == 0 ? 0 : a[n - 1] >> (32 - shift);
+	for (size_t i = n; i > 0; --i) {
+		limb_t u0 = shifted(a, i - 1, shift);
+		q[i - 1] = div_3by2(r, u0, d, v);
+	}
+	return r >> shift;
+}
+
+limb_t limb_kernels::lshift(limb_t *r, limb_t const *a, size_t n, unsigned cnt) {
+	if (cnt == 0) {
+		std::copy_backward(a, a + n, r + n);
+		return 0;
+	}
+	limb_t out = 0;
+	for (size_t i = n; i > 0; --i) {
+		limb_t x = a[i - 1];
+		if (i == n) {
+			out = x >> (32 - cnt);
+		}
+		r[i - 1] = (x << cnt) | (i > 1 ? a[i - 2] >> (32 - cnt) : 0);
+	}
+	return out;
+}
+
+limb_t limb_kernels::rshift(limb_t *r, limb_t const *a, size_t n, unsigned cnt) {
+	if (cnt == 0) {
+		std::copy(a, a + n, r);
+		return 0;
+	}
+	limb_t out = n > 0 ? a[0] << (32 - cnt) : 0;
+	for (size_t i = 0; i < n; ++i) {
+		r[i] = (a[i] >> cnt) | (i + 1 < n ? a[i + 1] << (32 - cnt) : 0);
+	}
+	return out;
+}
+
+limb_t limb_kernels::binvert_limb(limb_t d) {
+	// метод Ньютона: d * d == 1 mod 8, и каждый шаг удваивает число верных бит
+	limb_t x = d;
+	for (int i = 0; i < 4; ++i) {
+		x *= 2 - d * x;
+	}
+	return x;
+}
+
+void limb_kernels::divexact(limb_t *q, limb_t *u, size_t un, limb_t const *d, size_t dn) {
+	limb_t inv = binvert_limb(d[0]);
+	size_t qn = un - dn + 1;
+	for (size_t i = 0; i < qn; ++i) {
+		q[i] = u[i] * inv;
+		// столбцы не младше qn на частное уже не влияют
+		size_t len = std::min(dn, qn - i);
+		limb_t borrow = submul_1(u + i, d, len, q[i]);
+		sub_1(u + i + len, u + i + len, qn - i - len, borrow);
+	}
+}
+
+bool limb_kernels::divisible_odd(limb_t *u, size_t un, limb_t const *d, size_t dn) {
+	limb_t inv = binvert_limb(d[0]);
+	size_t qn = un - dn + 1;
+	for (size_t i = 0; i < qn; ++i) {
+		limb_t borrow = submul_1(u + i, d, dn, u[i] * inv);
+		// заём за старший лимб: u - q * d < 0, и дальше только уменьшается
+		if (sub_1(u + i + dn, u + i + dn, un - i - dn, borrow) != 0) {
+			return false;
+		}
+	}
+	for (size_t i = qn; i < un; ++i) {
+		if (u[i] != 0) {
+			return false;
+		}
+	}
+	return true;
+}
+
+int limb_kernels::cmp_n(limb_t const *a, limb_t const *b, size_t n) {
+	for (size_t i = n; i > 0; --i) {
+		if (a[i - 1] != b[i - 1]) {
+			return a[i - 1] < b[i - 1] ? -1 : 1;
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,98 @@
+#ifndef LIMB_KERNELS_H
+#define LIMB_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Примитивы над сырыми массивами лимбов (младший лимб первый). Результат r может совпадать
+// с входом a (или b) целиком, но не пересекаться с ним со сдвигом. Возвращают перенос / заём из старшего лимба.
+struct limb_kernels {
+	using limb_t = uint32_t;
+
+	// r[0..n) = a[0..n) + b[0..n)
+	static limb_t add_n(limb_t *r, limb_t const *a, limb_t const *b, size_t n);
+	// r[0..n) = a[0..n) - b[0..n)
+	static limb_t sub_n(limb_t *r, limb_t const *a, limb_t const *b, size_t n);
+	// r[0..n) = a[0..n) + b, перенос бежит до первого лимба без переполнения
+	static limb_t add_1(limb_t *r, limb_t const *a, size_t n, limb_t b);
+	// r[0..n) = a[0..n) - b
+	static limb_t sub_1(limb_t *r, limb_t const *a, size_t n, limb_t b);
+	// r[0..n) = a[0..n) * b, возвращает старший лимб произведения
+	static limb_t mul_1(limb_t *r, limb_t const *a, size_t n, limb_t b);
+	// r[0..n) += a[0..n) * b, возвращает то, что не поместилось в n лимбов
+	static limb_t addmul_1(limb_t *r, limb_t const *a, size_t n, limb_t b);
+	// r[0..n) += a[0..n) * b для b из двух лимбов (младший первый), возвращает то, что не поместилось в n лимбов.
+	// Одно умножение 64 x 64 вместо двух проходов addmul_1
+	static uint64_t addmul_2(limb_t *r, limb_t const *a, size_t n, uint64_t b);
+	// r[0..n) -= a[0..n) * b, возвращает заём из r[n]
+	static limb_t submul_1(limb_t *r, limb_t const *a, size_t n, limb_t b);
+	// r[0..n + m) = a[0..n) * b[0..m) столбиком; r не пересекается с a и b
+	static void mul_basecase(limb_t *r, limb_t const *a, size_t n, limb_t const *b, size_t m);
+	// q[0..n) = a[0..n) / d, возвращает остаток; d != 0
+	static limb_t divrem_1(limb_t *q, limb_t const *a, size_t n, limb_t d);
+
+	// Деление на инвариантный делитель с заранее посчитанной обратной величиной (Möller, Granlund 2011):
+	// вместо инструкции div на каждый лимб -- два умножения и пара редко срабатывающих поправок.
+	// d здесь нормализован (старший бит равен 1) и равен исходному делителю, сдвинутому на shift бит влево.
+	// v = floor((B^2 - 1) / d) - B для одного лимба
+	static limb_t invert_limb(limb_t d);
+	// v = floor((B^3 - 1) / d) - B для двух лимбов
+	static limb_t invert_pair(uint64_t d);
+	static limb_t divrem_1_preinv(limb_t *q, limb_t const *a, size_t n, limb_t d, unsigned shift, limb_t v);
+	// q[0..n) = a[0..n) / d для двухлимбового d, возвращает остаток
+	static uint64_t divrem_2_preinv(limb_t *q, limb_t const *a, size_t n, uint64_t d, unsigned shift, limb_t v);
+	// r[0..n) = a[0..n) << cnt и a[0..n) >> cnt для 0 <= cnt < 32; возвращают выдвинутые биты,
+	// прижатые к противоположному краю лимба. r может совпадать с a
+	static limb_t lshift(limb_t *r, limb_t const *a, size_t n, unsigned cnt);
+	static limb_t rshift(limb_t *r, limb_t const *a, size_t n, unsigned cnt);
+
+	// d^(-1) mod 2^32 для нечётного d
+	static limb_t binvert_limb(limb_t d);
+	// Точное деление по Хенселю (Jebelean): частное набирается от младших лимбов к старшим,
+	// q_i = u_i * d^(-1) mod B, без оценки частного. d нечётен, un >= dn, u портится.
+	// divexact считает q[0..un - dn + 1), полагаясь на то, что d делит u, и трогает только нужные столбцы;
+	// divisible_odd частное не хранит и проверяет, что остаток нулевой
+	static void divexact(limb_t *q, limb_t *u, size_t un, limb_t const *d, size_t dn);
+	static bool divisible_odd(limb_t *u, size_t un, limb_t const *d, size_t dn);
+	// сравнение a[0..n) и b[0..n) как чисел: -1, 0 или 1
+	static int cmp_n(limb_t const *a, limb_t const *b, size_t n);
+
+	// Поразрядные r[0..n) = a & b, a | b, a ^ b, a & ~b и ~a (limb_kernels_bitwise.cpp).
+	// Векторные версии для AVX-512, AVX2 и SSE2 выбираются по процессору при первом вызове
+	static void and_n(limb_t *r, limb_t const *a, limb_t const *b, size_t n);
+	static void ior_n(limb_t *r, limb_t const *a, limb_t const *b, size_t n);
+	static void xor_n(limb_t *r, limb_t const *a, limb_t const *b, size_t n);
+	static void andn_n(limb_t *r, limb_t const *a, limb_t const *b, size_t n);
+	static void com(limb_t *r, limb_t const *a, size_t n);
+
+	// Наборы add_n, sub_n, mul_1, addmul_1, addmul_2 и submul_1 по уровням -- для сверки реализаций между собой.
+	// Функции выше сами берут лучший из доступных уровней при первом вызове: adx, затем longarith
+	// (ассемблерные циклы из ../asm, если собраны; addmul_1, addmul_2 и submul_1 у него переносимые), затем generic
+	enum class arith_tier { generic, longarith, adx };
+	struct arith_table {
+		limb_t (*add_n)(limb_t *r, limb_t const *a, limb_t const *b, size_t n);
+		limb_t (*sub_n)(limb_t *r, limb_t const *a, limb_t const *b, size_t n);
+		limb_t (*mul_1)(limb_t *r, limb_t const *a, size_t n, limb_t b);
+		limb_t (*addmul_1)(limb_t *r, limb_t const *a, size_t n, limb_t b);
+		uint64_t (*addmul_2)(limb_t *r, limb_t const *a, size_t n, uint64_t b);
+		limb_t (*submul_1)(limb_t *r, limb_t const *a, size_t n, limb_t b);
+	};
+	// уровень собран и поддерживается процессором
+	static bool available(arith_tier tier);
+	static arith_table table(arith_tier tier);
+
+	// то же для поразрядных операций; лучший уровень -- самый широкий вектор
+	enum class bitwise_tier { scalar, sse2, avx2, avx512 };
+	struct bitwise_table {
+		void (*and_n)(limb_t *r, limb_t const *a, limb_t const *b, size_t n);
+		void (*ior_n)(limb_t *r, limb_t const *a, limb_t const *b, size_t n);
+		void (*xor_n)(limb_t *r, limb_t const *a, limb_t const *b, size_t n);
+		void (*andn_n)(limb_t *r, limb_t const *a, limb_t const *b, size_t n);
+		// b не читается
+		void (*com)(limb_t *r, limb_t const *a, limb_t const *b, size_t n);
+	};
+	static bool available(bitwise_tier tier);
+	static bitwise_table table(bitwise_tier tier);
+};
+
+#endif //LIMB_KERNELS_H
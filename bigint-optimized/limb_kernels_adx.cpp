@@ -0,0 +1,208 @@
+#include "limb_kernels_adx.h"
+
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+using limb_t = limb_kernels_adx::limb_t;
+
+#if defined(__x86_64__)
+
+namespace {
+
+using word_t = unsigned long long;
+__extension__ typedef unsigned __int128 dword_t;
+
+// лимбы выровнены только на 4 байта, поэтому слова читаются через memcpy (это обычный mov)
+word_t load(limb_t const *p) {
+	word_t w;
+	std::memcpy(&w, p, sizeof(w));
+	return w;
+}
+
+void store(limb_t *p, word_t w) {
+	std::memcpy(p, &w, sizeof(w));
+}
+
+}
+
+bool limb_kernels_adx::supported() {
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("adx") && __builtin_cpu_supports("bmi2");
+}
+
+__attribute__((target("adx"))) limb_t limb_kernels_adx::add_n(limb_t *r, limb_t const *a, limb_t const *b, size_t n) {
+	unsigned char carry = 0;
+	size_t i = 0;
+	for (; i + 2 <= n; i += 2) {
+		word_t s;
+		carry = _addcarryx_u64(carry, load(a + i), load(b + i), &s);
+		store(r + i, s);
+	}
+	if (i < n) {
+		uint64_t t = static_cast<uint64_t>(a[i]) + b[i] + carry;
+		r[i] = static_cast<limb_t>(t);
+		carry = static_cast<unsigned char>(t >> 32u);
+	}
+	return carry;
+}
+
+__attribute__((target("adx"))) limb_t limb_kernels_adx::sub_n(limb_t *r, limb_t const *a, limb_t const *b, size_t n) {
+	unsigned char borrow = 0;
+	size_t i = 0;
+	for (; i + 2 <= n; i += 2) {
+		word_t s;
+		borrow = _subborrow_u64(borrow, load(a + i), load(b + i), &s);
+		store(r + i, s);
+	}
+	if (i < n) {
+		uint64_t t = static_cast<uint64_t>(a[i]) - b[i] - borrow;
+		r[i] = static_cast<limb_t>(t);
+		borrow = static_cast<unsigned char>((t >> 32u) & 1u);
+	}
+	return borrow;
+}
+
+// b < 2^32, так что перенос между словами тоже меньше 2^32 и в конце помещается в лимб
+__attribute__((target("bmi2"))) limb_t limb_kernels_adx::mul_1(limb_t *r, limb_t const *a, size_t n, limb_t b) {
+	word_t carry = 0;
+	size_t i = 0;
+	for (; i + 2 <= n; i += 2) {
+		dword_t p = static_cast<dword_t>(load(a + i)) * b + carry;
+		store(r + i, static_cast<word_t>(p));
+		carry = static_cast<word_t>(p >> 64u);
+	}
+	if (i < n) {
+		carry += static_cast<uint64_t>(a[i]) * b;
+		r[i] = static_cast<limb_t>(carry);
+		carry >>= 32u;
+	}
+	return static_cast<limb_t>(carry);
+}
+
+namespace {
+
+// r[0..2 * words) += a[0..2 * words) * b по 64-битным словам, возвращает старшее слово.
+// b -- полное 64-битное слово, так что из этого же цикла собраны и addmul_1, и addmul_2.
+// r[i] + lo(a[i] * b) идёт цепочкой CF (adcx), старшая половина предыдущего произведения -- цепочкой OF (adox).
+// Цикл развёрнут на два слова (четыре лимба); счётчик уменьшается через lea и проверяется jrcxz,
+// которые флагов не трогают. Непарное младшее слово считается до цикла, его перенос входит в цепочку OF
+__attribute__((target("adx,bmi2"))) word_t addmul_words(limb_t *rp, limb_t const *ap, size_t words, word_t b) {
+	word_t carry = 0;
+	if (words % 2 != 0) {
+		dword_t p = static_cast<dword_t>(load(ap)) * b + load(rp);
+		store(rp, static_cast<word_t>(p));
+		carry = static_cast<word_t>(p >> 64u);
+		rp += 2;
+		ap += 2;
+	}
+	size_t pairs = words / 2;
+	if (pairs != 0) {
+		word_t lo0, hi0, lo1, hi1;
+		__asm__(
+			"xorl %k[lo0], %k[lo0]\n\t"
+			"1:\n\t"
+			"mulxq (%[ap]), %[lo0], %[hi0]\n\t"
+			"adcxq (%[rp]), %[lo0]\n\t"
+			"adoxq %[carry], %[lo0]\n\t"
+			"movq %[lo0], (%[rp])\n\t"
+			"mulxq 8(%[ap]), %[lo1], %[hi1]\n\t"
+			"adcxq 8(%[rp]), %[lo1]\n\t"
+			"adoxq %[hi0], %[lo1]\n\t"
+			"movq %[lo1], 8(%[rp])\n\t"
+			"movq %[hi1], %[carry]\n\t"
+			"leaq 16(%[ap]), %[ap]\n\t"
+			"leaq 16(%[rp]), %[rp]\n\t"
+			"leaq -1(%[pairs]), %[pairs]\n\t"
+			"jrcxz 2f\n\t"
+			"jmp 1b\n\t"
+			"2:\n\t"
+			"movl $0, %k[lo0]\n\t"
+			"adcxq %[lo0], %[carry]\n\t"
+			"adoxq %[lo0], %[carry]\n\t"
+			: [carry] "+r"(carry), [lo0] "=&r"(lo0), [hi0] "=&r"(hi0), [lo1] "=&r"(lo1), [hi1] "=&r"(hi1),
+			  [rp] "+r"(rp), [ap] "+r"(ap), [pairs] "+c"(pairs)
+			: "d"(b)
+			: "cc", "memory");
+	}
+	return carry;
+}
+
+}
+
+__attribute__((target("adx,bmi2"))) limb_t limb_kernels_adx::addmul_1(limb_t *r, limb_t const *a, size_t n, limb_t b) {
+	word_t carry = addmul_words(r, a, n / 2, b);
+	if (n % 2 != 0) {
+		carry += static_cast<uint64_t>(a[n - 1]) * b + r[n - 1];
+		r[n - 1] = static_cast<limb_t>(carry);
+		carry >>= 32u;
+	}
+	return static_cast<limb_t>(carry);
+}
+
+// нечётный старший лимб на 64-битное b даёт до 96 бит
+__attribute__((target("adx,bmi2"))) uint64_t limb_kernels_adx::addmul_2(limb_t *r, limb_t const *a, size_t n, uint64_t b) {
+	word_t carry = addmul_words(r, a, n / 2, b);
+	if (n % 2 != 0) {
+		dword_t p = static_cast<dword_t>(a[n - 1]) * b + r[n - 1] + carry;
+		r[n - 1] = static_cast<limb_t>(p);
+		carry = static_cast<word_t>(p >> 32u);
+	}
+	return carry;
+}
+
+__attribute__((target("bmi2"))) limb_t limb_kernels_adx::submul_1(limb_t *r, limb_t const *a, size_t n, limb_t b) {
+	word_t carry = 0;
+	size_t i = 0;
+	for (; i + 2 <= n; i += 2) {
+		dword_t p = static_cast<dword_t>(load(a + i)) * b + carry;
+		word_t lo = static_cast<word_t>(p);
+		carry = static_cast<word_t>(p >> 64u);
+		word_t x = load(r + i);
+		carry += lo > x ? 1 : 0;
+		store(r + i, x - lo);
+	}
+	if (i < n) {
+		carry += static_cast<uint64_t>(a[i]) * b;
+		limb_t lo = static_cast<limb_t>(carry);
+		carry >>= 32u;
+		carry += lo > r[i] ? 1 : 0;
+		r[i] -= lo;
+	}
+	return static_cast<limb_t>(carry);
+}
+
+#else
+
+// не x86-64: limb_kernels всегда берёт переносимые версии
+bool limb_kernels_adx::supported() {
+	return false;
+}
+
+limb_t limb_kernels_adx::add_n(limb_t *, limb_t const *, limb_t const *, size_t) {
+	return 0;
+}
+
+limb_t limb_kernels_adx::sub_n(limb_t *, limb_t const *, limb_t const *, size_t) {
+	return 0;
+}
+
+limb_t limb_kernels_adx::mul_1(limb_t *, limb_t const *, size_t, limb_t) {
+	return 0;
+}
+
+limb_t limb_kernels_adx::addmul_1(limb_t *, limb_t const *, size_t, limb_t) {
+	return 0;
+}
+
+uint64_t limb_kernels_adx::addmul_2(limb_t *, limb_t const *, size_t, uint64_t) {
+	return 0;
+}
+
+limb_t limb_kernels_adx::submul_1(limb_t *, limb_t const *, size_t, limb_t) {
+	return 0;
+}
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef LIMB_KERNELS_ADX_H
+#define LIMB_KERNELS_ADX_H
+
+#include "limb_kernels.h"
+
+// Версии основных примитивов limb_kernels для x86-64 с ADX и BMI2: лимбы берутся парами как 64-битные
+// слова, переносы идут флагом процессора (adc/sbb), умножение -- mulx, а в addmul_1 и addmul_2 две цепочки
+// переносов adcx/adox идут параллельно. Нечётный старший лимб досчитывается отдельно.
+// Вызываются только через limb_kernels, и только если supported().
+struct limb_kernels_adx {
+	using limb_t = limb_kernels::limb_t;
+
+	static bool supported();
+
+	static limb_t add_n(limb_t *r, limb_t const *a, limb_t const *b, size_t n);
+	static limb_t sub_n(limb_t *r, limb_t const *a, limb_t const *b, size_t n);
+	static limb_t mul_1(limb_t *r, limb_t const *a, size_t n, limb_t b);
+	static limb_t addmul_1(limb_t *r, limb_t const *a, size_t n, limb_t b);
+	static uint64_t addmul_2(limb_t *r, limb_t const *a, size_t n, uint64_t b);
+	static limb_t submul_1(limb_t *r, limb_t const *a, size_t n, limb_t b);
+};
+
+#endif //LIMB_KERNELS_ADX_H
@@ -0,0 +1,82 @@
+#include "limb_kernels_asm.h"
+#include "longarith.h"
+
+#include <algorithm>
+
+using limb_t = limb_kernels_asm::limb_t;
+
+namespace {
+
+uint64_t *words(limb_t *p) {
+	return reinterpret_cast<uint64_t *>(p);
+}
+
+uint64_t const *words(limb_t const *p) {
+	return reinterpret_cast<uint64_t const *>(p);
+}
+
+}
+
+limb_t limb_kernels_asm::add_n(limb_t *r, limb_t const *a, limb_t const *b, size_t n) {
+	size_t w = n / 2;
+	limb_t last_a = n % 2 != 0 ? a[n - 1] : 0;
+	limb_t last_b = n % 2 != 0 ? b[n - 1] : 0;
+	// сложение коммутативно: на месте можно прибавлять к любому из операндов
+	if (r == b) {
+		std::swap(a, b);
+	} else if (r != a) {
+		std::copy(a, a + 2 * w, r);
+	}
+	uint64_t carry = add_long_long(words(r), words(b), w);
+	if (n % 2 != 0) {
+		carry += static_cast<uint64_t>(last_a) + last_b;
+		r[n - 1] = static_cast<limb_t>(carry);
+		carry >>= 32u;
+	}
+	return static_cast<limb_t>(carry);
+}
+
+limb_t limb_kernels_asm::sub_n(limb_t *r, limb_t const *a, limb_t const *b, size_t n) {
+	size_t w = n / 2;
+	limb_t last_a = n % 2 != 0 ? a[n - 1] : 0;
+	limb_t last_b = n % 2 != 0 ? b[n - 1] : 0;
+	uint64_t borrow;
+	if (r == b && r != a) {
+		// r = a - b на месте b: r = -(b - a), заём -- признак b > a
+		uint64_t rev = sub_long_long(words(r), words(a), w);
+		bool nonzero = false;
+		for (size_t i = 0; i < 2 * w; ++i) {
+			nonzero = nonzero || r[i] != 0;
+			r[i] = ~r[i];
+		}
+		limb_kernels::add_1(r, r, 2 * w, 1);
+		borrow = nonzero && rev == 0 ? 1 : 0;
+	} else {
+		if (r != a) {
+			std::copy(a, a + 2 * w, r);
+		}
+		borrow = sub_long_long(words(r), words(b), w);
+	}
+	if (n % 2 != 0) {
+		uint64_t t = static_cast<uint64_t>(last_a) - last_b - borrow;
+		r[n - 1] = static_cast<limb_t>(t);
+		borrow = (t >> 32u) & 1u;
+	}
+	return static_cast<limb_t>(borrow);
+}
+
+// b < 2^32, так что старший qword произведения меньше 2^32 и помещается в лимб
+limb_t limb_kernels_asm::mul_1(limb_t *r, limb_t const *a, size_t n, limb_t b) {
+	size_t w = n / 2;
+	limb_t last = n % 2 != 0 ? a[n - 1] : 0;
+	if (r != a) {
+		std::copy(a, a + 2 * w, r);
+	}
+	uint64_t carry = mul_long_short(words(r), w, b);
+	if (n % 2 != 0) {
+		carry += static_cast<uint64_t>(last) * b;
+		r[n - 1] = static_cast<limb_t>(carry);
+		carry >>= 32u;
+	}
+	return static_cast<limb_t>(carry);
+}
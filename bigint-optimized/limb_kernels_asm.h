@@ -0,0 +1,18 @@
+#ifndef LIMB_KERNELS_ASM_H
+#define LIMB_KERNELS_ASM_H
+
+#include "limb_kernels.h"
+
+// add_n, sub_n и mul_1 поверх ассемблерных циклов из ../asm/longarith.asm (библиотека longarith).
+// Те работают на месте над qword'ами, поэтому лимбы берутся парами, нечётный старший лимб досчитывается
+// здесь, а для r != a операнд сначала копируется в r. Собирается, только если найден nasm
+// (тогда определён BIG_INTEGER_ASM_KERNELS), и вызывается только через limb_kernels.
+struct limb_kernels_asm {
+	using limb_t = limb_kernels::limb_t;
+
+	static limb_t add_n(limb_t *r, limb_t const *a, limb_t const *b, size_t n);
+	static limb_t sub_n(limb_t *r, limb_t const *a, limb_t const *b, size_t n);
+	static limb_t mul_1(limb_t *r, limb_t const *a, size_t n, limb_t b);
+};
+
+#endif //LIMB_KERNELS_ASM_H
@@ -0,0 +1,254 @@
+#include "limb_kernels.h"
+
+#include <initializer_list>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+using limb_t = limb_kernels::limb_t;
+
+namespace {
+
+// Каждая операция -- набор одинаковых по смыслу функций для лимба и для векторов разной ширины.
+// Второй аргумент com игнорирует.
+struct and_op {
+	static limb_t scalar(limb_t a, limb_t b) {
+		return a & b;
+	}
+#if defined(__x86_64__)
+	static __m128i sse2(__m128i a, __m128i b) {
+		return _mm_and_si128(a, b);
+	}
+	__attribute__((target("avx2"))) static __m256i avx2(__m256i a, __m256i b) {
+		return _mm256_and_si256(a, b);
+	}
+	__attribute__((target("avx512f"))) static __m512i avx512(__m512i a, __m512i b) {
+		return _mm512_and_si512(a, b);
+	}
+#endif
+};
+
+struct ior_op {
+	static limb_t scalar(limb_t a, limb_t b) {
+		return a | b;
+	}
+#if defined(__x86_64__)
+	static __m128i sse2(__m128i a, __m128i b) {
+		return _mm_or_si128(a, b);
+	}
+	__attribute__((target("avx2"))) static __m256i avx2(__m256i a, __m256i b) {
+		return _mm256_or_si256(a, b);
+	}
+	__attribute__((target("avx512f"))) static __m512i avx512(__m512i a, __m512i b) {
+		return _mm512_or_si512(a, b);
+	}
+#endif
+};
+
+struct xor_op {
+	static limb_t scalar(limb_t a, limb_t b) {
+		return a ^ b;
+	}
+#if defined(__x86_64__)
+	static __m128i sse2(__m128i a, __m128i b) {
+		return _mm_xor_si128(a, b);
+	}
+	__attribute__((target("avx2"))) static __m256i avx2(__m256i a, __m256i b) {
+		return _mm256_xor_si256(a, b);
+	}
+	__attribute__((target("avx512f"))) static __m512i avx512(__m512i a, __m512i b) {
+		return _mm512_xor_si512(a, b);
+	}
+#endif
+};
+
+// a & ~b; у andnot инвертируется первый операнд
+struct andn_op {
+	static limb_t scalar(limb_t a, limb_t b) {
+		return a & ~b;
+	}
+#if defined(__x86_64__)
+	static __m128i sse2(__m128i a, __m128i b) {
+		return _mm_andnot_si128(b, a);
+	}
+	__attribute__((target("avx2"))) static __m256i avx2(__m256i a, __m256i b) {
+		return _mm256_andnot_si256(b, a);
+	}
+	// _mm512_andnot_si512 в GCC берёт неинициализированный вектор под маску и сыплет -Wmaybe-uninitialized
+	__attribute__((target("avx512f"))) static __m512i avx512(__m512i a, __m512i b) {
+		return _mm512_ternarylogic_epi32(a, b, b, 0x30);
+	}
+#endif
+};
+
+struct com_op {
+	static limb_t scalar(limb_t a, limb_t) {
+		return ~a;
+	}
+#if defined(__x86_64__)
+	static __m128i sse2(__m128i a, __m128i) {
+		return _mm_xor_si128(a, _mm_set1_epi32(-1));
+	}
+	__attribute__((target("avx2"))) static __m256i avx2(__m256i a, __m256i) {
+		return _mm256_xor_si256(a, _mm256_set1_epi32(-1));
+	}
+	__attribute__((target("avx512f"))) static __m512i avx512(__m512i a, __m512i) {
+		return _mm512_ternarylogic_epi32(a, a, a, 0x55);
+	}
+#endif
+};
+
+template <typename Op>
+void bitwise_scalar(limb_t *r, limb_t const *a, limb_t const *b, size_t n) {
+	for (size_t i = 0; i < n; ++i) {
+		r[i] = Op::scalar(a[i], b[i]);
+	}
+}
+
+#if defined(__x86_64__)
+// невыровненные загрузки: лимбы лежат в векторах без особого выравнивания, а r может совпадать с a или b
+template <typename Op>
+void bitwise_sse2(limb_t *r, limb_t const *a, limb_t const *b, size_t n) {
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		__m128i x = _mm_loadu_si128(reinterpret_cast<__m128i const *>(a + i));
+		__m128i y = _mm_loadu_si128(reinterpret_cast<__m128i const *>(b + i));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(r + i), Op::sse2(x, y));
+	}
+	bitwise_scalar<Op>(r + i, a + i, b + i, n - i);
+}
+
+template <typename Op>
+__attribute__((target("avx2"))) void bitwise_avx2(limb_t *r, limb_t const *a, limb_t const *b, size_t n) {
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		__m256i x = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(a + i));
+		__m256i y = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(b + i));
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(r + i), Op::avx2(x, y));
+	}
+	bitwise_sse2<Op>(r + i, a + i, b + i, n - i);
+}
+
+// хвост короче вектора обрабатывается той же инструкцией под маской
+template <typename Op>
+__attribute__((target("avx512f"))) void bitwise_avx512(limb_t *r, limb_t const *a, limb_t const *b, size_t n) {
+	size_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		__m512i x = _mm512_loadu_si512(a + i);
+		__m512i y = _mm512_loadu_si512(b + i);
+		_mm512_storeu_si512(r + i, Op::avx512(x, y));
+	}
+	if (i < n) {
+		__mmask16 mask = static_cast<__mmask16>((1u << (n - i)) - 1);
+		__m512i x = _mm512_maskz_loadu_epi32(mask, a + i);
+		__m512i y = _mm512_maskz_loadu_epi32(mask, b + i);
+		_mm512_mask_storeu_epi32(r + i, mask, Op::avx512(x, y));
+	}
+}
+#endif
+
+using bitwise_table = limb_kernels::bitwise_table;
+using bitwise_tier = limb_kernels::bitwise_tier;
+
+template <template <typename> class Impl>
+bitwise_table make_table() {
+	return {Impl<and_op>::run, Impl<ior_op>::run, Impl<xor_op>::run, Impl<andn_op>::run, Impl<com_op>::run};
+}
+
+template <typename Op>
+struct scalar_impl {
+	static void run(limb_t *r, limb_t const *a, limb_t const *b, size_t n) {
+		bitwise_scalar<Op>(r, a, b, n);
+	}
+};
+
+#if defined(__x86_64__)
+template <typename Op>
+struct sse2_impl {
+	static void run(limb_t *r, limb_t const *a, limb_t const *b, size_t n) {
+		bitwise_sse2<Op>(r, a, b, n);
+	}
+};
+
+template <typename Op>
+struct avx2_impl {
+	static void run(limb_t *r, limb_t const *a, limb_t const *b, size_t n) {
+		bitwise_avx2<Op>(r, a, b, n);
+	}
+};
+
+template <typename Op>
+struct avx512_impl {
+	static void run(limb_t *r, limb_t const *a, limb_t const *b, size_t n) {
+		bitwise_avx512<Op>(r, a, b, n);
+	}
+};
+#endif
+
+// выбирается один раз, при первом обращении; SSE2 есть у любого x86-64
+bitwise_table pick_table() {
+	for (bitwise_tier tier : {bitwise_tier::avx512, bitwise_tier::avx2, bitwise_tier::sse2}) {
+		if (limb_kernels::available(tier)) {
+			return limb_kernels::table(tier);
+		}
+	}
+	return limb_kernels::table(bitwise_tier::scalar);
+}
+
+bitwise_table const &bitwise() {
+	static bitwise_table const table = pick_table();
+	return table;
+}
+
+}
+
+bool limb_kernels::available(bitwise_tier tier) {
+#if defined(__x86_64__)
+	__builtin_cpu_init();
+	if (tier == bitwise_tier::avx512) {
+		return __builtin_cpu_supports("avx512f");
+	}
+	if (tier == bitwise_tier::avx2) {
+		return __builtin_cpu_supports("avx2");
+	}
+	return true;
+#else
+	return tier == bitwise_tier::scalar;
+#endif
+}
+
+limb_kernels::bitwise_table limb_kernels::table(bitwise_tier tier) {
+#if defined(__x86_64__)
+	if (tier == bitwise_tier::avx512) {
+		return make_table<avx512_impl>();
+	}
+	if (tier == bitwise_tier::avx2) {
+		return make_table<avx2_impl>();
+	}
+	if (tier == bitwise_tier::sse2) {
+		return make_table<sse2_impl>();
+	}
+#endif
+	return make_table<scalar_impl>();
+}
+
+void limb_kernels::and_n(limb_t *r, limb_t const *a, limb_t const *b, size_t n) {
+	bitwise().and_n(r, a, b, n);
+}
+
+void limb_kernels::ior_n(limb_t *r, limb_t const *a, limb_t const *b, size_t n) {
+	bitwise().ior_n(r, a, b, n);
+}
+
+void limb_kernels::xor_n(limb_t *r, limb_t const *a, limb_t const *b, size_t n) {
+	bitwise().xor_n(r, a, b, n);
+}
+
+void limb_kernels::andn_n(limb_t *r, limb_t const *a, limb_t const *b, size_t n) {
+	bitwise().andn_n(r, a, b, n);
+}
+
+void limb_kernels::com(limb_t *r, limb_t const *a, size_t n) {
+	bitwise().com(r, a, a, n);
+}
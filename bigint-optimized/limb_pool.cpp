@@ -0,0 +1,147 @@
+#include "limb_pool.h"
+
+#include <new>
+
+namespace {
+
+struct free_block {
+	free_block *next;
+};
+
+// POD без деструктора: остаётся доступным и после того, как поток начал разрушать свои thread_local
+struct pool_state {
+	free_block *free_lists[limb_pool::CLASS_COUNT];
+	size_t bytes_retained;
+	size_t retain_limit;
+	size_t allocations;
+	size_t hits;
+	bool registered;
+};
+
+// при завершении потока отдаёт всё накопленное обратно в кучу
+struct pool_guard {
+	~pool_guard();
+};
+
+thread_local pool_state state = {{}, 0, limb_pool::DEFAULT_RETAIN_LIMIT, 0, 0, false};
+thread_local pool_guard guard;
+
+pool_state &local_state() {
+	if (!state.registered) {
+		state.registered = true;
+		static_cast<void>(&guard);
+	}
+	return state;
+}
+
+pool_guard::~pool_guard() {
+	limb_pool::trim();
+	// всё, что освободится позже (например, статические объекты), сразу уходит в кучу
+	state.retain_limit = 0;
+}
+
+size_t size_class(size_t bytes) {
+	if (bytes <= (static_cast<size_t>(1) << limb_pool::MIN_CLASS_SHIFT)) {
+		return 0;
+	}
+	size_t shift = 64 - __builtin_clzll(static_cast<unsigned long long>(bytes - 1));
+	return shift - limb_pool::MIN_CLASS_SHIFT;
+}
+
+size_t class_bytes(size_t cls) {
+	return static_cast<size_t>(1) << (cls + limb_pool::MIN_CLASS_SHIFT);
+}
+
+// блоки из ::operator new и пула выровнены по 16 байт, большего лимбам не нужно
+struct pool_resource : std::pmr::memory_resource {
+  private:
+	void *do_allocate(size_t bytes, size_t alignment) override {
+		if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+			throw std::bad_alloc();
+		}
+		return limb_pool::allocate(bytes);
+	}
+
+	void do_deallocate(void *p, size_t bytes, size_t) override {
+		limb_pool::deallocate(p, bytes);
+	}
+
+	bool do_is_equal(std::pmr::memory_resource const &other) const noexcept override {
+		return this == &other;
+	}
+};
+
+}
+
+std::pmr::memory_resource *limb_pool::resource() {
+	// никогда не разрушается: статические числа освобождаются после конца main
+	alignas(pool_resource) static unsigned char storage[sizeof(pool_resource)];
+	static pool_resource *instance = new (storage) pool_resource();
+	return instance;
+}
+
+void *limb_pool::allocate(size_t bytes) {
+	pool_state &s = local_state();
+	s.allocations++;
+	size_t cls = size_class(bytes);
+	if (cls >= CLASS_COUNT) {
+		return ::operator new(bytes);
+	}
+	free_block *block = s.free_lists[cls];
+	if (block != nullptr) {
+		s.free_lists[cls] = block->next;
+		s.bytes_retained -= class_bytes(cls);
+		s.hits++;
+		return block;
+	}
+	return ::operator new(class_bytes(cls));
+}
+
+void limb_pool::deallocate(void *p, size_t bytes) {
+	if (p == nullptr) {
+		return;
+	}
+	pool_state &s = local_state();
+	size_t cls = size_class(bytes);
+	if (cls >= CLASS_COUNT || s.bytes_retained + class_bytes(cls) > s.retain_limit) {
+		::operator delete(p);
+		return;
+	}
+	auto *block = static_cast<free_block *>(p);
+	block->next = s.free_lists[cls];
+	s.free_lists[cls] = block;
+	s.bytes_retained += class_bytes(cls);
+}
+
+double limb_pool::statistics::hit_rate() const {
+	return allocations == 0 ? 0 : static_cast<double>(hits) / static_cast<double>(allocations);
+}
+
+limb_pool::statistics limb_pool::stats() {
+	pool_state &s = local_state();
+	return {s.allocations, s.hits, s.bytes_retained, s.retain_limit};
+}
+
+void limb_pool::reset_stats() {
+	pool_state &s = local_state();
+	s.allocations = 0;
+	s.hits = 0;
+}
+
+void limb_pool::set_retain_limit(size_t bytes) {
+	local_state().retain_limit = bytes;
+	trim(bytes);
+}
+
+void limb_pool::trim(size_t keep_bytes) {
+	pool_state &s = state;
+	// сначала выбрасываем крупные блоки: так быстрее уложиться в лимит
+	for (size_t cls = CLASS_COUNT; cls > 0 && s.bytes_retained > keep_bytes; --cls) {
+		while (s.free_lists[cls - 1] != nullptr && s.bytes_retained > keep_bytes) {
+			free_block *block = s.free_lists[cls - 1];
+			s.free_lists[cls - 1] = block->next;
+			s.bytes_retained -= class_bytes(cls - 1);
+			::operator delete(block);
+		}
+	}
+}
@@ -0,0 +1,69 @@
+#ifndef LIMB_POOL_H
+#define LIMB_POOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+
+// Пул буферов под лимбы. Размер запроса округляется вверх до степени двойки,
+// освобождённые буферы кладутся в thread_local список свободных блоков своего класса
+// и отдаются следующему запросу того же класса без обращения к куче.
+// Числа, созданные внутри limb_arena::scope, берут буферы не отсюда, а из арены потока.
+struct limb_pool {
+	static size_t constexpr MIN_CLASS_SHIFT = 4;   // 16 байт
+	static size_t constexpr MAX_CLASS_SHIFT = 20;  // 1 Мб, всё что больше идёт мимо пула
+	static size_t constexpr CLASS_COUNT = MAX_CLASS_SHIFT - MIN_CLASS_SHIFT + 1;
+	static size_t constexpr DEFAULT_RETAIN_LIMIT = static_cast<size_t>(8) << 20u;
+
+	// статистика текущего потока
+	struct statistics {
+		size_t allocations;     // все запросы, включая большие
+		size_t hits;            // запросы, обслуженные из списка свободных блоков
+		size_t bytes_retained;  // байт лежит в списках свободных блоков
+		size_t retain_limit;
+
+		double hit_rate() const;
+	};
+
+	static void *allocate(size_t bytes);
+	static void deallocate(void *p, size_t bytes);
+	// тот же пул в виде std::pmr::memory_resource
+	static std::pmr::memory_resource *resource();
+
+	static statistics stats();
+	static void reset_stats();
+	// блоки сверх лимита при освобождении сразу возвращаются в кучу
+	static void set_retain_limit(size_t bytes);
+	// возвращает в кучу свободные блоки, пока в пуле лежит больше keep_bytes
+	static void trim(size_t keep_bytes = 0);
+};
+
+template <typename T>
+struct pool_allocator {
+	using value_type = T;
+
+	pool_allocator() = default;
+
+	template <typename U>
+	pool_allocator(pool_allocator<U> const &) {}
+
+	T *allocate(size_t n) {
+		return static_cast<T *>(limb_pool::allocate(n * sizeof(T)));
+	}
+
+	void deallocate(T *p, size_t n) {
+		limb_pool::deallocate(p, n * sizeof(T));
+	}
+};
+
+template <typename T, typename U>
+bool operator==(pool_allocator<T> const &, pool_allocator<U> const &) {
+	return true;
+}
+
+template <typename T, typename U>
+bool operator!=(pool_allocator<T> const &, pool_allocator<U> const &) {
+	return false;
+}
+
+#endif //LIMB_POOL_H
@@ -0,0 +1,182 @@
+#include "montgomery_context.h"
+#include "limb_kernels.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+// два младших лимба одним словом
+uint64_t low_word(big_integer::digit_t const *t, size_t n) {
+	return n > 1 ? (static_cast<uint64_t>(t[1]) << 32u) | t[0] : t[0];
+}
+
+// t[0..len) += c, c -- из двух лимбов; перенос за t[len) не выходит
+void add_word(big_integer::digit_t *t, size_t len, uint64_t c) {
+	big_integer::digit_t d[2] = {static_cast<big_integer::digit_t>(c), static_cast<big_integer::digit_t>(c >> 32u)};
+	big_integer::digit_t carry = limb_kernels::add_n(t, t, d, 2);
+	limb_kernels::add_1(t + 2, t + 2, len - 2, carry);
+}
+}
+
+montgomery_context::montgomery_context(big_integer const &modulus)
+	: mod(modulus), n(modulus.size()), inv(0), inv2(0) {
+	// лимбы модуля читаются напрямую, поэтому он хранится в каноническом виде
+	mod.normalize();
+	if (mod <= 0 || mod.value[0] % 2 == 0) {
+		throw std::runtime_error("montgomery_context: modulus must be positive and odd");
+	}
+	digit_t x = limb_kernels::binvert_limb(mod.value[0]);
+	inv = 0 - x;
+	// ещё один шаг Ньютона удваивает число верных бит обратного до 64
+	uint64_t m2 = low_word(mod.value.data(), n);
+	uint64_t x2 = x;
+	x2 *= 2 - m2 * x2;
+	inv2 = 0 - x2;
+	r_mod = big_integer(1) << static_cast<int>(32 * n);
+	r_mod %= mod;
+	r2_mod = r_mod * r_mod % mod;
+}
+
+big_integer const &montgomery_context::modulus() const {
+	return mod;
+}
+
+big_integer const &montgomery_context::one() const {
+	return r_mod;
+}
+
+// лимбы операнда из [0, m), дополненные нулями до n
+big_integer::digit_t const *montgomery_context::operand(scratch_space::frame &frame, big_integer const &a) const {
+	if (a.size() == n) {
+		return a.value.data();
+	}
+	digit_t *res = frame.alloc(n);
+	std::copy(a.value.begin(), a.value.begin() + a.size(), res);
+	std::fill(res + a.size(), res + n, 0);
+	return res;
+}
+
+// res = t[n..2n] (< 2m) по модулю m
+void montgomery_context::assign(big_integer &res, digit_t const *t) const {
+	digit_t const *m = mod.value.data();
+	res.value.assign(t, t + n);
+	res.inf_1_after_last_digit = false;
+	if (t[n] != 0 || limb_kernels::cmp_n(res.value.data(), m, n) >= 0) {
+		limb_kernels::sub_n(res.value.data(), res.value.data(), m, n);
+	}
+}
+
+// res = t * R^(-1) mod m для t[0..2n + 1) < m * R; t портится.
+// q на два лимба обнуляет сразу два младших лимба t, при нечётном n последний шаг -- по одному
+void montgomery_context::redc(big_integer &res, digit_t *t) const {
+	digit_t const *m = mod.value.data();
+	size_t i = 0;
+	for (; i + 2 <= n; i += 2) {
+		uint64_t q = low_word(t + i, 2) * inv2;
+		uint64_t carry = limb_kernels::addmul_2(t + i, m, n, q);
+		add_word(t + i + n, n + 1 - i, carry);
+	}
+	for (; i < n; ++i) {
+		digit_t q = t[i] * inv;
+		digit_t carry = limb_kernels::addmul_1(t + i, m, n, q);
+		limb_kernels::add_1(t + i + n, t + i + n, n + 1 - i, carry);
+	}
+	assign(res, t + n);
+}
+
+big_integer montgomery_context::to_montgomery(big_integer const &a) const {
+	big_integer res = a % mod;
+	if (res < 0) {
+		res += mod;
+	}
+	mul(res, res, r2_mod);
+	return res;
+}
+
+big_integer montgomery_context::from_montgomery(big_integer const &a) const {
+	scratch_space::frame frame;
+	digit_t const *x = operand(frame, a);
+	digit_t *t = frame.alloc(2 * n + 1);
+	std::copy(x, x + n, t);
+	std::fill(t + n, t + 2 * n + 1, 0);
+	big_integer res(a.get_allocator());
+	redc(res, t);
+	return res;
+}
+
+// CIOS: на шаге i к t прибавляется a * (b[i], b[i + 1]), затем q * m так, чтобы два младших лимба t обнулились;
+// вместо сдвига t вправо окно t + i просто едет по буферу из 2n + 2 лимбов. При нечётном n последний шаг -- по лимбу
+void montgomery_context::mul(big_integer &res, big_integer const &a, big_integer const &b) const {
+	scratch_space::frame frame;
+	digit_t const *x = operand(frame, a);
+	digit_t const *y = operand(frame, b);
+	digit_t const *m = mod.value.data();
+	digit_t *t = frame.alloc(2 * n + 2);
+	std::fill(t, t + 2 * n + 2, 0);
+	size_t i = 0;
+	for (; i + 2 <= n; i += 2) {
+		uint64_t c1 = limb_kernels::addmul_2(t + i, x, n, low_word(y + i, 2));
+		uint64_t q = low_word(t + i, 2) * inv2;
+		uint64_t c2 = limb_kernels::addmul_2(t + i, m, n, q);
+		// окно t + i до шага меньше 2m, после -- меньше 2m * (2^64 + 1): n + 3 лимба
+		add_word(t + i + n, 3, c1);
+		add_word(t + i + n, 3, c2);
+	}
+	for (; i < n; ++i) {
+		digit_t c1 = limb_kernels::addmul_1(t + i, x, n, y[i]);
+		digit_t q = t[i] * inv;
+		digit_t c2 = limb_kernels::addmul_1(t + i, m, n, q);
+		uint64_t sum = static_cast<uint64_t>(t[i + n]) + c1 + c2;
+		t[i + n] = static_cast<digit_t>(sum);
+		t[i + n + 1] += static_cast<digit_t>(sum >> 32u);
+	}
+	assign(res, t + n);
+}
+
+// a^2: недиагональные произведения считаются один раз и удваиваются, потом редукция по лимбам
+void montgomery_context::sqr(big_integer &res, big_integer const &a) const {
+	scratch_space::frame frame;
+	digit_t const *x = operand(frame, a);
+	digit_t *t = frame.alloc(2 * n + 1);
+	std::fill(t, t + 2 * n + 1, 0);
+	// строки i и i + 1 идут одним addmul_2 по x[i + 2..n), недостающее x[i] * x[i + 1] прибавляется отдельно
+	size_t i = 0;
+	for (; i + 3 <= n; i += 2) {
+		uint64_t top = limb_kernels::addmul_2(t + 2 * i + 2, x + i + 2, n - i - 2, low_word(x + i, 2));
+		t[i + n] = static_cast<digit_t>(top);
+		t[i + n + 1] = static_cast<digit_t>(top >> 32u);
+		add_word(t + 2 * i + 1, 2 * n - 2 * i - 1, static_cast<uint64_t>(x[i]) * x[i + 1]);
+	}
+	if (i + 1 < n) {
+		t[i + n] = limb_kernels::addmul_1(t + 2 * i + 1, x + i + 1, n - i - 1, x[i]);
+	}
+	limb_kernels::add_n(t, t, t, 2 * n);
+	for (i = 0; i < n; ++i) {
+		uint64_t sq = static_cast<uint64_t>(x[i]) * x[i];
+		digit_t d[2] = {static_cast<digit_t>(sq), static_cast<digit_t>(sq >> 32u)};
+		digit_t carry = limb_kernels::add_n(t + 2 * i, t + 2 * i, d, 2);
+		limb_kernels::add_1(t + 2 * i + 2, t + 2 * i + 2, 2 * n - 2 * i - 1, carry);
+	}
+	redc(res, t);
+}
+
+void montgomery_context::add(big_integer &res, big_integer const &a, big_integer const &b) const {
+	scratch_space::frame frame;
+	digit_t const *x = operand(frame, a);
+	digit_t const *y = operand(frame, b);
+	digit_t *t = frame.alloc(n + 1);
+	t[n] = limb_kernels::add_n(t, x, y, n);
+	assign(res, t);
+}
+
+void montgomery_context::sub(big_integer &res, big_integer const &a, big_integer const &b) const {
+	scratch_space::frame frame;
+	digit_t const *x = operand(frame, a);
+	digit_t const *y = operand(frame, b);
+	digit_t *t = frame.alloc(n + 1);
+	if (limb_kernels::sub_n(t, x, y, n) != 0) {
+		limb_kernels::add_n(t, t, mod.value.data(), n);
+	}
+	t[n] = 0;
+	assign(res, t);
+}
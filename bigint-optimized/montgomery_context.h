@@ -0,0 +1,44 @@
+#ifndef MONTGOMERY_CONTEXT_H
+#define MONTGOMERY_CONTEXT_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "big_integer.h"
+
+// Арифметика по фиксированному нечётному модулю m в форме Монтгомери: число x хранится как x * R mod m,
+// где R = 2^(32 * n), n -- число лимбов m. Умножение не делит на m: редукция идёт по два лимба за раз
+// вперемешку с умножением (CIOS), поэтому длинные цепочки (a * b) % m обходятся без limb_div.
+// Все операнды mul/sqr/add/sub -- уже в форме Монтгомери, то есть из [0, m); результат может совпадать с операндом.
+struct montgomery_context {
+	explicit montgomery_context(big_integer const &modulus);
+
+	big_integer const &modulus() const;
+	// R mod m -- единица в форме Монтгомери
+	big_integer const &one() const;
+
+	// a -- любое целое, в том числе отрицательное или больше m
+	big_integer to_montgomery(big_integer const &a) const;
+	big_integer from_montgomery(big_integer const &a) const;
+
+	void mul(big_integer &res, big_integer const &a, big_integer const &b) const;
+	void sqr(big_integer &res, big_integer const &a) const;
+	void add(big_integer &res, big_integer const &a, big_integer const &b) const;
+	void sub(big_integer &res, big_integer const &a, big_integer const &b) const;
+
+  private:
+	using digit_t = big_integer::digit_t;
+
+	big_integer mod;
+	size_t n;
+	digit_t inv;  // -m^(-1) mod 2^32
+	uint64_t inv2;  // -m^(-1) mod 2^64, для шагов по два лимба
+	big_integer r_mod;  // R mod m
+	big_integer r2_mod;  // R^2 mod m
+
+	digit_t const *operand(scratch_space::frame &frame, big_integer const &a) const;
+	void redc(big_integer &res, digit_t *t) const;
+	void assign(big_integer &res, digit_t const *t) const;
+};
+
+#endif //MONTGOMERY_CONTEXT_H
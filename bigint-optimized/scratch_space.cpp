@@ -0,0 +1,56 @@
+#include "scratch_space.h"
+
+#include <cassert>
+
+namespace {
+
+struct scratch_state {
+	chunk_stack chunks;
+	size_t depth;
+	bool registered;
+};
+
+struct scratch_guard {
+	~scratch_guard();
+};
+
+thread_local scratch_state state = {chunk_stack(), 0, false};
+thread_local scratch_guard guard;
+
+scratch_state &local_state() {
+	if (!state.registered) {
+		state.registered = true;
+		static_cast<void>(&guard);
+	}
+	return state;
+}
+
+scratch_guard::~scratch_guard() {
+	scratch_space::release();
+}
+
+}
+
+scratch_space::frame::frame() {
+	scratch_state &s = local_state();
+	saved = s.chunks.get_mark();
+	s.depth++;
+}
+
+scratch_space::frame::~frame() {
+	state.chunks.rollback(saved);
+	state.depth--;
+}
+
+uint32_t *scratch_space::frame::alloc(size_t limbs) {
+	return static_cast<uint32_t *>(state.chunks.allocate(limbs * sizeof(uint32_t), MIN_CHUNK_SIZE));
+}
+
+size_t scratch_space::bytes_reserved() {
+	return state.chunks.reserved();
+}
+
+void scratch_space::release() {
+	assert(state.depth == 0);
+	state.chunks.release();
+}
@@ -0,0 +1,32 @@
+#ifndef SCRATCH_SPACE_H
+#define SCRATCH_SPACE_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "chunk_stack.h"
+
+// Стек лимбов потока под временные буферы алгоритмов (в духе TMP_ALLOC из GMP).
+// frame запоминает вершину стека и откатывает её в деструкторе, поэтому в установившемся
+// режиме умножение и деление не обращаются к куче за временной памятью.
+struct scratch_space {
+	static size_t constexpr MIN_CHUNK_SIZE = static_cast<size_t>(16) << 10u;
+
+	struct frame {
+		frame();
+		~frame();
+		frame(frame const &) = delete;
+		frame &operator=(frame const &) = delete;
+
+		uint32_t *alloc(size_t limbs);
+
+	  private:
+		chunk_stack::mark saved;
+	};
+
+	static size_t bytes_reserved();
+	// отдаёт куче всю память стека; вызывать только вне frame
+	static void release();
+};
+
+#endif //SCRATCH_SPACE_H
@@ -6,10 +6,10 @@
 #include <iostream>
 
 shared_data::shared_data(size_t size, uint32_t digit)
-	: ref_cnt(1), buffer(std::vector<uint32_t>(size, digit)) {}
+	: ref_cnt(1), buffer(size, digit) {}
 
-shared_data::shared_data(std::vector<uint32_t> const &digits)
-	: ref_cnt(1), buffer(std::vector<uint32_t>(digits)) {}
+shared_data::shared_data(buffer_t const &digits)
+	: ref_cnt(1), buffer(digits) {}
 
 shared_data::shared_data(uint32_t *begin, uint32_t *end)
     : ref_cnt(1), buffer(begin, end) {}
@@ -26,7 +26,7 @@ uint32_t *shared_data::data() {
 	return buffer.data();
 }
 
-std::vector<uint32_t> const &shared_data::get_buffer() const {
+shared_data::buffer_t const &shared_data::get_buffer() const {
 	return buffer;
 }
 
@@ -8,13 +8,17 @@
 #include <cstdint>
 #include <vector>
 
+#include "limb_pool.h"
+
 struct shared_data {
   public:
+	using buffer_t = std::vector<uint32_t, pool_allocator<uint32_t>>;
+
 	size_t ref_cnt;
-	std::vector<uint32_t> buffer;
+	buffer_t buffer;
 
 	shared_data(size_t, uint32_t);
-	explicit shared_data(std::vector<uint32_t> const &);
+	explicit shared_data(buffer_t const &);
 	shared_data(uint32_t *begin, uint32_t *end);
 	~shared_data() = default;
 	void resize(size_t i);
@@ -22,7 +26,7 @@ struct shared_data {
 	void push_back(uint32_t);
 	void pop_back();
 	uint32_t *data();
-	std::vector<uint32_t> const &get_buffer() const;
+	buffer_t const &get_buffer() const;
 	uint32_t const &operator[](size_t) const;
 	uint32_t &operator[](size_t);
 	void dec();